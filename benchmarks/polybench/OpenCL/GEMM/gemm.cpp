@@ -113,9 +113,9 @@ void init(DATA_TYPE *A, DATA_TYPE *B, DATA_TYPE *C)
 
 void cl_mem_init(DATA_TYPE* A, DATA_TYPE* B, DATA_TYPE* C,Queue& queue)
 {
-	a_mem_obj = new Buffer(*(platform->getContext()), Buffer::ReadWrite, sizeof(DATA_TYPE) * NI * NK, NULL);
-	b_mem_obj = new Buffer(*(platform->getContext()), Buffer::ReadWrite, sizeof(DATA_TYPE) * NK * NJ, NULL);
-	c_mem_obj = new Buffer(*(platform->getContext()), Buffer::ReadWrite, sizeof(DATA_TYPE) * NI * NJ, NULL);
+	a_mem_obj = new Buffer(*(platform->getContext()), Buffer::ReadWrite, sizeof(DATA_TYPE) * NI * NK, NULL, "A");
+	b_mem_obj = new Buffer(*(platform->getContext()), Buffer::ReadWrite, sizeof(DATA_TYPE) * NK * NJ, NULL, "B");
+	c_mem_obj = new Buffer(*(platform->getContext()), Buffer::ReadWrite, sizeof(DATA_TYPE) * NI * NJ, NULL, "C");
 		
 
 	queue.writeBuffer(*a_mem_obj, sizeof(DATA_TYPE) * NI * NK, A);
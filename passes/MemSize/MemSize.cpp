@@ -146,7 +146,7 @@ namespace {
     
         //if instruction is a load or store
         if((isa<StoreInst>(i)) || (isa<LoadInst>(i)) ){  
-          if(is_global(i)){  //if instruction acesses global memory
+          if(is_global(i) || is_local(i)){  //if instruction acesses global or local memory
     
             //get pointer to counter
             Value *GEP = builder.CreateInBoundsGEP(trace_arg,ArrayRef<Value*>(builder.getInt32(0)));
@@ -154,7 +154,8 @@ namespace {
             //atomically load and increment the trace index
             builder.CreateCall(atomicINC_hook,GEP,"a_inc");
 
-            if(isa<StoreInst>(i))
+            //Local stores stay, later local loads may depend on them
+            if(isa<StoreInst>(i) && is_global(i))
               toDelete.push_back(i);
 
           }
@@ -279,6 +280,16 @@ namespace {
 
   //checks that memory access is to global memory
   bool is_global(Instruction* i){
+    return address_space(i) == 1;
+  }
+
+  //checks that memory access is to local memory
+  bool is_local(Instruction* i){
+    return address_space(i) == 3;
+  }
+
+  //address space of the pointer a load or store accesses
+  unsigned int address_space(Instruction* i){
     Value* pointer_op;
     
     if(isa<StoreInst>(i)){
@@ -290,11 +301,7 @@ namespace {
 
     Type *addr_space = (pointer_op->getType());
 
-    if(cast<PointerType>(addr_space)->getAddressSpace() == 1)
-      return true;
-    else
-      return false;
-  
+    return cast<PointerType>(addr_space)->getAddressSpace();
   }
 
   //sets up inital information
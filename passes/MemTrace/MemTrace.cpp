@@ -39,6 +39,8 @@ namespace {
 
    std::map<BasicBlock*,Loop> loop_map; 
 
+   std::set<Value*> stored_args;  //Kernel arguments the kernel stores through
+
    int inst_ctr;                //counts number of memory access instructions
    int loop_ctr;                //counts number of loops
 
@@ -130,6 +132,9 @@ namespace {
       }            
     } 
 
+    //Find arguments written by the kernel, before any trace stores are added
+    find_stored_args(F);
+
     //Identify loops in basic blocks
     for(Function::iterator func_itr = F->begin(), func_end = F->end(); func_itr != func_end; ++func_itr){
       MemTrace::runOnBasicBlock(func_itr);
@@ -146,7 +151,7 @@ namespace {
 
       //if instruction is load or store
       if((isa<StoreInst>(i)) || (isa<LoadInst>(i)) ){  
-        if(is_global(i)){  //if instrcution access global memory
+        if(is_global(i) || is_local(i)){  //if instrcution access global or local memory
          
           //get pointer to counter
           Value *GEP = builder.CreateInBoundsGEP(trace_arg,ArrayRef<Value*>(builder.getInt32(0)));
@@ -156,7 +161,7 @@ namespace {
           Value *counter= builder.CreateCall(atomicINC_hook,GEP,"atomic_inc");
 
           //add trace information
-          add_trace(i,counter,trace_arg,t_id_arg,loop_arg);
+          add_trace(i,counter,trace_arg,t_id_arg,loop_arg,is_local(i),is_read_only(i));
 
           inst_ctr++;
         }
@@ -211,6 +216,44 @@ namespace {
 
   //checks that memory access is to global memory
   bool is_global(Instruction* i){
+    return address_space(i) == 1;
+  }
+
+  //checks that memory access is to local memory
+  bool is_local(Instruction* i){
+    return address_space(i) == 3;
+  }
+
+  /*
+    checks that a load reads a buffer which can go through the read-only
+    data path: a 'restrict' (noalias) kernel argument the kernel never
+    stores through, as for 'const __global T* restrict'
+  */
+  bool is_read_only(Instruction* i){
+    if(!isa<LoadInst>(i) || !is_global(i))
+      return false;
+
+    Value* base = GetUnderlyingObject(cast<LoadInst>(i)->getPointerOperand());
+    if(!isa<Argument>(base) || !cast<Argument>(base)->hasNoAliasAttr())
+      return false;
+
+    return stored_args.find(base) == stored_args.end();
+  }
+
+  //records the kernel arguments global stores write through
+  void find_stored_args(Module::iterator &F){
+    stored_args.clear();
+    for(inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I){
+      if(isa<StoreInst>(&*I) && is_global(&*I)){
+        Value* base = GetUnderlyingObject(cast<StoreInst>(&*I)->getPointerOperand());
+        if(isa<Argument>(base))
+          stored_args.insert(base);
+      }
+    }
+  }
+
+  //address space of the pointer a load or store accesses
+  unsigned int address_space(Instruction* i){
     Value* pointer_op;
     if(isa<StoreInst>(i)){
       pointer_op= cast<StoreInst>(i)->getPointerOperand();
@@ -221,16 +264,16 @@ namespace {
 
    Type *addr_space = (pointer_op->getType());
 
-   if(cast<PointerType>(addr_space)->getAddressSpace() == 1)
-      return true;
-   else
-      return false;
-  
+   return cast<PointerType>(addr_space)->getAddressSpace();
   }
 
 
-  //adds trace information about instuction i to the trace parameter at specified index
-  void add_trace(Instruction* i, Value* index,Value* trace_arg, Value* t_id_arg,Value* loop_arg){
+  /*
+    adds trace information about instuction i to the trace parameter at specified index.
+    The 4 bits above the instruction name give the access type: F global load,
+    A global store, E local load, B local store, D global load of read-only data.
+  */
+  void add_trace(Instruction* i, Value* index,Value* trace_arg, Value* t_id_arg,Value* loop_arg,bool local,bool read_only){
     Value* addr;
     IRBuilder<> builder(i);
 
@@ -247,7 +290,7 @@ namespace {
       name = addr->getName();
       addr = builder.CreateShl(addr,32,"addr_sl",false,false);
      
-      Value* type = builder.getInt64(10);
+      Value* type = builder.getInt64(local ? 11 : 10);
 
       type= builder.CreateShl(type,28);
       addr = builder.CreateOr(addr,type);
@@ -262,7 +305,7 @@ namespace {
       addr = builder.CreatePointerCast(cast<LoadInst>(i)->getPointerOperand(),int64_Ty);
       addr = builder.CreateShl(addr,32,"addr_sl",false,false);
 
-      Value* type = builder.getInt64(15);
+      Value* type = builder.getInt64(local ? 14 : (read_only ? 13 : 15));
 
       type= builder.CreateShl(type,28);
       addr = builder.CreateOr(addr,type);
@@ -5,6 +5,7 @@
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/Support/InstIterator.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/CommandLine.h"
@@ -13,4 +14,5 @@
 #include "llvm/IR/Type.h"
 #include "llvm/Pass.h"
 #include <map>
+#include <set>
 #include <stdio.h>
@@ -1,6 +1,8 @@
 #ifndef BUFFER_H
 #define BUFFER_H
 
+#include <string>
+
 #include <CL/cl.h>
 
 class Context;
@@ -21,15 +23,18 @@ public:
 //------------------------------------------------------------------------------
 public:
   Buffer(const Context& context, MemoryFlags flags, size_t size, 
-         void *host_ptr);
+         void *host_ptr, const char* name = NULL);
   ~Buffer() throw();
 
 public:
   cl_mem getId() const;
+  size_t getSize() const;
+  const std::string& getName() const;  // Empty unless named when created
 
 private:
   cl_mem buffer;
   size_t size;
+  std::string name;                     // Name the trace tools report it by
 };
 
 #endif
@@ -1,17 +1,28 @@
 #ifndef KERNEL_H
 #define KERNEL_H
 #include <stdio.h>
+#include <string>
+#include <vector>
 #include <CL/cl.h>
 
 #define TRACE1_SIZE  5 //number of 'long long' entries in the added buffer for
                        //the first transformation
 
 #define FILE_NAME "trace.txt"
+#define BUFFER_FILE_NAME "buffers.txt"   //Device address ranges of buffer arguments
 
 class Buffer;
 class Device;
 class Program;
 
+// Buffer passed as a kernel argument
+struct BufferArgument {
+  cl_uint index;          // Argument index, as the benchmark numbers it
+  cl_mem buffer;
+  size_t size;
+  std::string name;
+};
+
 class Kernel {
 
 // Constructors and Destructors.
@@ -47,6 +58,9 @@ public:
   //Uses information from the first trace to allocate data for the second trace
   void alloc(const size_t *localSize,unsigned int dim);
 
+  //Records the device address range of each buffer argument
+  void write_buffers(cl_command_queue queue);
+
   // OpenCL 1.2 only.
   //std::vector<size_t> getMaxGlobalWorkSize(const Device& device) const;
   size_t getMaxWorkGroupSize(const Device& device) const;
@@ -61,6 +75,11 @@ private:
   cl_kernel kernel;                             // Kernel from second transformation
   cl_kernel length_kernel;                      // Kernel from first transformation
 
+  std::vector<BufferArgument> buffer_args;      // Buffers set as arguments
+  cl_program probe_program;                     // Reads the device address of a buffer
+  cl_kernel probe_kernel;
+  cl_mem probe_buffer;
+
 };
 
 // Traits.
@@ -5,7 +5,8 @@
 #include "Utils.h"
 
 Buffer::Buffer(const Context& context, MemoryFlags flags, size_t size, 
-               void* hostPtr) : size(size) {
+               void* hostPtr, const char* name) : size(size), 
+               name(name ? name : "") {
   cl_int errorCode;
   buffer = clCreateBuffer(context.getId(), flags, size, hostPtr, 
                           &errorCode);
@@ -19,3 +20,11 @@ Buffer::~Buffer() throw() {
 cl_mem Buffer::getId() const {
   return buffer;
 }
+
+size_t Buffer::getSize() const {
+  return size;
+}
+
+const std::string& Buffer::getName() const {
+  return name;
+}
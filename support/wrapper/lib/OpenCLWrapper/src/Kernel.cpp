@@ -14,7 +14,8 @@
 
 void verifySetArgumentCode(int errorCode, unsigned int index);
 //------------------------------------------------------------------------------
-Kernel::Kernel(const Program& program, const char* name) {
+Kernel::Kernel(const Program& program, const char* name) :
+               probe_program(NULL), probe_kernel(NULL), probe_buffer(NULL) {
   cl_int errorCode;
 
   // Get rid of any exising traces
@@ -25,6 +26,13 @@ Kernel::Kernel(const Program& program, const char* name) {
   }
   fclose(fp);
 
+  fp = fopen(BUFFER_FILE_NAME,"w"); 
+  if(fp ==NULL){
+    std::cout <<"error opening output file\n";
+    exit(1); 
+  }
+  fclose(fp);
+
   /*
     Create host memory for added buffer in prelimary transformation.
     Contains five entries, one for the length counter, initalized to zero, and 
@@ -79,6 +87,11 @@ Kernel::~Kernel() throw() {
   clReleaseMemObject(addr_buffer);
   clReleaseKernel(kernel);
   clReleaseKernel(length_kernel);
+  if(probe_kernel != NULL){
+    clReleaseMemObject(probe_buffer);
+    clReleaseKernel(probe_kernel);
+    clReleaseProgram(probe_program);
+  }
 
   free(h_trace1);
  
@@ -254,6 +267,75 @@ void Kernel::write_trace(const size_t* local,unsigned int dim) const {
  
 }
 
+/*
+   Appends the device address range of each buffer argument to the buffer
+   file, followed by the same terminator as the trace, so the trace tools
+   can attribute accesses to buffers. OpenCL does not expose device
+   addresses, so a probe kernel is run to read each one.
+*/
+void Kernel::write_buffers(cl_command_queue queue) {
+  cl_int errorCode;
+
+  FILE* fp = fopen(BUFFER_FILE_NAME,"a");
+  if(fp == NULL){
+    printf("Error Opening output file\n");
+    exit(1);
+  }
+
+  if(!buffer_args.empty() && probe_kernel == NULL){
+    const char* source = 
+      "__kernel void probe(__global char* buffer, __global ulong* address){\n"
+      "  *address = (ulong)buffer;\n"
+      "}\n";
+
+    cl_context context;
+    errorCode = clGetKernelInfo(kernel,CL_KERNEL_CONTEXT,sizeof(cl_context),&context,NULL);
+    verifyOutputCode(errorCode, "Error querying the kernel context");
+
+    probe_program = clCreateProgramWithSource(context, 1, &source, NULL, &errorCode);
+    verifyOutputCode(errorCode, "Error creating the probe program");
+
+    errorCode = clBuildProgram(probe_program, 0, NULL, NULL, NULL, NULL);
+    verifyOutputCode(errorCode, "Error building the probe program");
+
+    probe_kernel = clCreateKernel(probe_program, "probe", &errorCode);
+    verifyOutputCode(errorCode, "Error creating the probe kernel");
+
+    probe_buffer = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(cl_ulong), 
+                                  NULL, &errorCode);
+    verifyOutputCode(errorCode, "Error creating the probe buffer");
+  }
+
+  for(unsigned int i=0;i<buffer_args.size();i++){
+    cl_ulong address = 0;
+
+    errorCode = clSetKernelArg(probe_kernel, 0, sizeof(cl_mem), &buffer_args[i].buffer);
+    errorCode |= clSetKernelArg(probe_kernel, 1, sizeof(cl_mem), &probe_buffer);
+    verifySetArgumentCode(errorCode, i);
+
+    errorCode = clEnqueueTask(queue, probe_kernel, 0, NULL, NULL);
+    verifyOutputCode(errorCode, "Error running the probe kernel");
+
+    errorCode = clEnqueueReadBuffer(queue, probe_buffer, CL_TRUE, 0, 
+                                    sizeof(cl_ulong), &address, 0, NULL, NULL);
+    verifyOutputCode(errorCode, "could not read buffer");
+
+    // Unnamed buffers are known by their argument index
+    std::string name = buffer_args[i].name;
+    if(name.empty()){
+      char arg[16];
+      sprintf(arg,"arg%u",buffer_args[i].index);
+      name = arg;
+    }
+
+    fprintf(fp,"%u %llX %lu %s\n",buffer_args[i].index,(unsigned long long)address,
+            (unsigned long)buffer_args[i].size,name.c_str());
+  }
+
+  fprintf(fp,"---------------\n");
+  fclose(fp);
+}
+
 //------------------------------------------------------------------------------
 void verifySetArgumentCode(int errorCode, unsigned int index) {
   if(isError(errorCode)) {
@@ -265,6 +347,14 @@ void verifySetArgumentCode(int errorCode, unsigned int index) {
 
 //------------------------------------------------------------------------------
 void Kernel::setArgument(unsigned int index, size_t size, const void* pointer) {
+
+  // The argument no longer holds any buffer it was given before
+  for(unsigned int i=0;i<buffer_args.size();i++){
+    if(buffer_args[i].index == index){
+      buffer_args.erase(buffer_args.begin() + i);
+      break;
+    }
+  }
   
   /*
      Shift each added kernel agurment up to facilitate instrumented parameters 
@@ -285,6 +375,13 @@ void Kernel::setArgument(unsigned int index, size_t size, const void* pointer) {
 void Kernel::setArgument(unsigned int index, const Buffer& buffer) {
   cl_mem rawBuffer = buffer.getId();
   setArgument(index, sizeof(cl_mem), &rawBuffer);
+
+  BufferArgument arg;
+  arg.index = index;
+  arg.buffer = rawBuffer;
+  arg.size = buffer.getSize();
+  arg.name = buffer.getName();
+  buffer_args.push_back(arg);
 }
 
 //------------------------------------------------------------------------------
@@ -159,9 +159,10 @@ void Queue::run( Kernel& kernel,
   verifyOutputCode(err, "could not read buffer");
  
   /*
-     Dump trace to file
+     Dump buffer address ranges and trace to file
   */ 
 
+  kernel.write_buffers(queue);
   kernel.write_trace(localSize,dimensionsNumber);
 
 
@@ -213,9 +214,10 @@ void Queue::run(Kernel& kernel,
   verifyOutputCode(err, "could not read buffer");
  
   /*
-     Dump trace to file
+     Dump buffer address ranges and trace to file
   */ 
  
+  kernel.write_buffers(queue);
   kernel.write_trace(localSize,dimensionsNumber);
 
 }
@@ -273,9 +275,10 @@ void Queue::run(Kernel& kernel,
   verifyOutputCode(err, "could not read buffer");
  
   /*
-     Dump trace to file
+     Dump buffer address ranges and trace to file
   */ 
  
+  kernel.write_buffers(queue);
   kernel.write_trace(localSize,dimensionsNumber);
 
 }
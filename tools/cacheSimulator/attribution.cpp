@@ -0,0 +1,121 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+
+#include "attribution.h"
+
+
+BufferStats::BufferStats(const BufferTable* t, unsigned int line):
+    table(t),line_size(line),buffers(NULL){}
+
+unsigned int BufferStats::slot(const std::string& name){
+  std::vector<std::string>::iterator match = std::find(names.begin(),names.end(),name);
+  if(match != names.end())
+    return match - names.begin();
+
+  names.push_back(name);
+  counts.push_back(BufferCount());
+  return names.size() - 1;
+}
+
+void BufferStats::begin_execution(unsigned int n){
+  if(!used())
+    return;
+
+  buffers = &table->execution(n);
+  current.clear();
+  for(unsigned int i=0;i<buffers->size();i++){
+    current.push_back(slot((*buffers)[i].name));
+  }
+}
+
+/*
+ * Accesses outside every buffer are counted under 'other'
+*/
+void BufferStats::access(const Entry& e, bool request, bool miss){
+  if(!buffers)
+    return;
+
+  int b = BufferTable::find(*buffers,e.address);
+  BufferCount& count = counts[b == -1 ? slot("other") : current[b]];
+
+  if(request && (e.op & OP_READ))
+    count.reads++;
+  else if(request)
+    count.writes++;
+  if(miss)
+    count.misses++;
+  count.lines.insert(e.address / line_size);
+}
+
+void BufferStats::clear_counts(){
+  for(unsigned int i=0;i<counts.size();i++){
+    counts[i] = BufferCount();
+  }
+}
+
+BufferStats& BufferStats::operator+= (const BufferStats& right){
+  if(!table)
+    table = right.table;
+  if(!line_size)
+    line_size = right.line_size;
+
+  for(unsigned int i=0;i<right.names.size();i++){
+    BufferCount& count = counts[slot(right.names[i])];
+    const BufferCount& other = right.counts[i];
+    count.reads += other.reads;
+    count.writes += other.writes;
+    count.misses += other.misses;
+    count.lines.insert(other.lines.begin(),other.lines.end());
+  }
+  return *this;
+}
+
+void BufferStats::getValues(std::vector<NamedStat>& values) const{
+  for(unsigned int i=0;i<names.size();i++){
+    std::string prefix = "buffer_" + names[i] + "_";
+    values.push_back(NamedStat(prefix + "reads",counts[i].reads));
+    values.push_back(NamedStat(prefix + "writes",counts[i].writes));
+    values.push_back(NamedStat(prefix + "misses",counts[i].misses));
+    values.push_back(NamedStat(prefix + "miss_rate",counts[i].getMissRate()));
+    values.push_back(NamedStat(prefix + "footprint",(double)counts[i].lines.size() * line_size));
+  }
+}
+
+std::ostream & operator<< (std::ostream & os, const BufferStats& right){
+  os<<"\n==================================\n";
+  os<<"BUFFERS\n";
+  os<<"==================================\n";
+
+  for(unsigned int i=0;i<right.names.size();i++){
+    const BufferCount& count = right.counts[i];
+    os<< right.names[i] <<":"<< std::endl;
+    os<<"  Reads:            "<< count.reads << std::endl;
+    os<<"  Writes:           "<< count.writes << std::endl;
+    os<<"  Misses:           "<< count.misses << std::endl;
+    os<<"  Miss Rate:        "<< count.getMissRate() << std::endl;
+    os<<"  Footprint(Bytes): "<< count.lines.size() * right.line_size << std::endl;
+  }
+  os<<std::endl;
+
+  return os;
+}
@@ -0,0 +1,73 @@
+/*
+ * attribution.h
+ *
+ * Attributes the accesses and misses of the cache to the buffers the kernel
+ * was given, from the address ranges the wrapper records.
+ */
+#ifndef ATTRIBUTION_H
+#define ATTRIBUTION_H
+
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer_table.h"
+#include "common.h"
+#include "stats.h"
+
+
+//Accesses of one buffer, and the cache lines they touched
+struct BufferCount
+{
+   BufferCount():reads(0),writes(0),misses(0){}
+
+   unsigned long reads;
+   unsigned long writes;
+   unsigned long misses;
+   std::unordered_set<unsigned long> lines;
+
+   double getMissRate() const { return reads + writes ? (double)misses / (reads + writes) : 0;}
+};
+
+
+class BufferStats
+{
+  public:
+    // Footprints are counted in lines of line_size bytes, taken from the
+    // first counts added if 0
+    BufferStats(const BufferTable* table, unsigned int line_size);
+
+    // Picks the address ranges of execution n
+    void begin_execution(unsigned int n);
+
+    // Every access adds to the footprint, only those the cache counted as
+    // requests to the reads or writes
+    void access(const Entry& e, bool request, bool miss);
+
+    void clear_counts();
+
+    // Sums counts by buffer name, footprints being the union of lines touched
+    BufferStats& operator+= (const BufferStats& right);
+
+    friend std::ostream & operator<< (std::ostream & os, const BufferStats& right);
+
+    // buffer_<name>_reads, _writes, _misses, _miss_rate and _footprint
+    void getValues(std::vector<NamedStat>& values) const;
+
+    bool used() const { return table && !table->empty();}
+
+  private:
+    // Counts kept under a buffer's name, added on first use
+    unsigned int slot(const std::string& name);
+
+    const BufferTable* table;
+    unsigned int line_size;
+
+    std::vector<std::string> names;       //Buffers seen, in order of first use
+    std::vector<BufferCount> counts;
+    std::vector<unsigned int> current;    //Slot of each buffer of the current execution
+    const BUFFER_VEC* buffers;            //Ranges of the current execution
+};
+
+#endif
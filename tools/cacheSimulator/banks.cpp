@@ -0,0 +1,125 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+
+#include "banks.h"
+
+
+Banks::Banks(const BankConfig& c):config(c),warp(0),inst(0){}
+
+void Banks::access(const Entry& e){
+
+  if(words.empty() || e.warp_id != warp || e.inst != inst){
+    flush();
+    warp = e.warp_id;
+    inst = e.inst;
+  }
+
+  ++total.accesses;
+  ++by_inst[e.inst].accesses;
+
+  //Threads reading the same word share it, a broadcast
+  unsigned int word = e.address / config.width;
+  if(std::find(words.begin(),words.end(),word) == words.end())
+    words.push_back(word);
+}
+
+/*
+ * The warp instruction needs as many passes as the most distinct
+ * words asked of a single bank.
+*/
+void Banks::flush(){
+  if(words.empty())
+    return;
+
+  std::vector<unsigned int> per_bank(config.banks,0);
+  unsigned int passes = 0;
+  for(unsigned int i=0;i<words.size();i++){
+    passes = std::max(passes,++per_bank[words[i] % config.banks]);
+  }
+
+  BankCount& count = by_inst[inst];
+  ++total.warp_insts;
+  ++count.warp_insts;
+
+  total.replays += passes - 1;
+  count.replays += passes - 1;
+
+  if(passes > 1){
+    ++total.conflicted;
+    ++count.conflicted;
+  }
+
+  words.clear();
+}
+
+void Banks::clear_counts(){
+  total = BankCount();
+  by_inst.clear();
+  words.clear();
+}
+
+Banks& Banks::operator+= (const Banks& right){
+  total.accesses += right.total.accesses;
+  total.warp_insts += right.total.warp_insts;
+  total.replays += right.total.replays;
+  total.conflicted += right.total.conflicted;
+
+  for(std::map<unsigned int,BankCount>::const_iterator iter = right.by_inst.begin(),
+      end = right.by_inst.end(); iter != end; ++iter){
+    BankCount& count = by_inst[iter->first];
+    count.accesses += iter->second.accesses;
+    count.warp_insts += iter->second.warp_insts;
+    count.replays += iter->second.replays;
+    count.conflicted += iter->second.conflicted;
+  }
+  return *this;
+}
+
+void Banks::getValues(std::vector<NamedStat>& values) const{
+  values.push_back(NamedStat("local_accesses",total.accesses));
+  values.push_back(NamedStat("local_warp_insts",total.warp_insts));
+  values.push_back(NamedStat("bank_replays",total.replays));
+  values.push_back(NamedStat("bank_conflicted_insts",total.conflicted));
+  values.push_back(NamedStat("replays_per_warp_inst",total.getReplaysPerInst()));
+}
+
+std::ostream & operator<< (std::ostream & os, const Banks& right){
+  os<<"\n==================================\n";
+  os<<"LOCAL MEMORY\n";
+  os<<"==================================\n";
+  os<<"Banks:             "<<right.config.banks <<" x "<<right.config.width <<" bytes"<< std::endl;
+  os<<"Accesses:          "<<right.total.accesses << std::endl;
+  os<<"Warp Instructions: "<<right.total.warp_insts << std::endl;
+  os<<"Conflicted:        "<<right.total.conflicted << std::endl;
+  os<<"Replays:           "<<right.total.replays << std::endl;
+  os<<"Replays per Inst:  "<<right.total.getReplaysPerInst() << std::endl;
+
+  for(std::map<unsigned int,BankCount>::const_iterator iter = right.by_inst.begin(),
+      end = right.by_inst.end(); iter != end; ++iter){
+    os<<"Instruction "<< iter->first <<": "<< iter->second.warp_insts <<" warp instructions, "
+      << iter->second.replays <<" replays, "<< iter->second.getReplaysPerInst() <<" per warp instruction"<< std::endl;
+  }
+  os<<std::endl;
+
+  return os;
+}
@@ -0,0 +1,79 @@
+/*
+ * banks.h
+ *
+ * Model of the banked local (shared) memory of a core. The accesses a warp
+ * instruction makes to local memory are spread over the banks, and every
+ * extra distinct word needed from one bank costs the instruction a replay.
+ */
+#ifndef BANKS_H
+#define BANKS_H
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "common.h"
+#include "stats.h"
+
+
+struct BankConfig
+{
+   unsigned int banks;     //Number of banks
+   unsigned int width;     //Bytes in a bank word, consecutive words go to consecutive banks
+};
+
+// Local memory of a GTX 480, 32 banks of 4 byte words
+const BankConfig BANKS_DEFAULT = {32, 4};
+
+
+//Local memory traffic, kept in total and for each instruction
+struct BankCount
+{
+   BankCount():accesses(0),warp_insts(0),replays(0),conflicted(0){}
+
+   unsigned long accesses;      //Thread accesses
+   unsigned long warp_insts;    //Warp instructions
+   unsigned long replays;       //Extra passes needed due to bank conflicts
+   unsigned long conflicted;    //Warp instructions with at least one replay
+
+   double getReplaysPerInst() const { return warp_insts ? (double)replays / warp_insts : 0;}
+};
+
+
+class Banks
+{
+  public:
+    Banks(const BankConfig& config);
+
+    /*
+     * Local memory access. Accesses with the same warp and instruction
+     * as the previous one belong to the same warp instruction.
+     */
+    void access(const Entry& e);
+
+    // Completes the warp instruction in progress
+    void flush();
+
+    void clear_counts();
+
+    Banks& operator+= (const Banks& right);
+
+    friend std::ostream & operator<< (std::ostream & os, const Banks& right);
+
+    void getValues(std::vector<NamedStat>& values) const;
+
+    bool used() const { return total.accesses != 0;}
+
+  private:
+    BankConfig config;
+
+    BankCount total;
+    std::map<unsigned int,BankCount> by_inst;
+
+    //Current warp instruction
+    unsigned int warp;
+    unsigned int inst;
+    std::vector<unsigned int> words;    //Distinct words accessed
+};
+
+#endif
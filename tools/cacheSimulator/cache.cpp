@@ -104,12 +104,22 @@ Cache::Cache(unsigned int num_lines, unsigned int lineSize, unsigned int assoc,
     last_id = 0;
     last_inst = 0;
 
+    pending_id = 0;
+    pending_inst = 0;
+    pending_stores = 0;
+
+    index_function = CACHE_INDEX_MODULO;
+    prime = num_sets;
+    prime_inverse = 0;
+    hash_bytes = 0;
+
 
     /*
      * Initialize shifts and masks.
     */
     get_shift_and_mask(line_size, &cache_index_shift, &line_offset_mask, 0);
     get_shift_and_mask(num_sets, &tag_shift, &cache_index_mask, cache_index_shift);
+    index_bits = tag_shift - cache_index_shift;
 
     /*
      * Initialize cache sets.
@@ -123,6 +133,93 @@ Cache::Cache(unsigned int num_lines, unsigned int lineSize, unsigned int assoc,
   
 }
 
+Cache::Cache(const CacheConfig& config)
+  :Cache(config.num_lines,config.line_size,config.associativity,config.rep_policy,config.write_policy)
+{
+    set_index_function(config.index);
+}
+
+/*
+ * Largest prime no greater than n.
+*/
+static unsigned int largest_prime(unsigned int n)
+{
+    for(; n > 2; n--){
+        bool prime = true;
+        for(unsigned int d = 2; d * d <= n && prime; d++){
+            prime = (n % d != 0);
+        }
+        if(prime)
+          return n;
+    }
+    return n;
+}
+
+/*
+ * Prepares the tables used by get_set for the chosen index function.
+*/
+void Cache::set_index_function(const IndexFunction& function)
+{
+    //A single set needs no index
+    index_function = index_bits ? function.type : CACHE_INDEX_MODULO;
+
+    if(index_function == CACHE_INDEX_MODULO)
+      return;
+
+    //Tag becomes the whole block address
+    tag_shift = cache_index_shift;
+
+    if(index_function == CACHE_INDEX_PRIME){
+      prime = largest_prime(num_sets);
+      prime_inverse = ~0ULL / prime + 1;
+      return;
+    }
+
+    if(index_function == CACHE_INDEX_XOR)
+      return;
+
+    //A permutation is the XOR matrix with a single bit in each row
+    std::vector<unsigned long> rows = function.rows;
+    if(index_function == CACHE_INDEX_PERMUTE){
+      rows.clear();
+      for(unsigned int i = 0; i < function.bits.size(); i++){
+        rows.push_back(1UL << function.bits[i]);
+      }
+    }
+
+    unsigned long used = 0;
+    for(unsigned int i = 0; i < rows.size() && i < index_bits; i++){
+        used |= rows[i];
+    }
+
+    hash_bytes = 0;
+    while(hash_bytes < sizeof(unsigned long) && (used >> (hash_bytes * 8)))
+      hash_bytes++;
+
+    hash_table.assign(hash_bytes << 8,0);
+    for(unsigned int b = 0; b < hash_bytes; b++){
+        for(unsigned int value = 0; value < 256; value++){
+            unsigned long bits = (unsigned long)value << (b * 8);
+
+            unsigned int set = 0;
+            for(unsigned int i = 0; i < rows.size() && i < index_bits; i++){
+                set |= (__builtin_popcountl(bits & rows[i]) & 1) << i;
+            }
+            hash_table[(b << 8) | value] = set;
+        }
+    }
+}
+
+Cache::~Cache()
+{
+    for (unsigned int i = 0; i < num_sets; i++){
+        for (unsigned int j = 0; j < associativity; j++){
+            delete sets[i].lines[j];
+        }
+        delete[] sets[i].lines;
+    }
+}
+
 /*
  * Determine whether or not a cache line is valid for a given tag.
 */
@@ -191,7 +288,7 @@ static int find_LFU_line(CacheSet& cache_set, int assoc){
 /*
  * Function to find a cache line to use for new data.
 */
-static CacheLine *find_available_cache_line(const Cache& cache, CacheSet& cache_set)
+static CacheLine *find_available_cache_line(Cache& cache, CacheSet& cache_set)
 {
 
      unsigned int N = cache.associativity;    
@@ -211,19 +308,24 @@ static CacheLine *find_available_cache_line(const Cache& cache, CacheSet& cache_
       }     
       
      //Random replacement
-     int randomIndex = rand() % N;
+     int randomIndex = cache.rng() % N;
      return cache_line_make_mru(cache_set,randomIndex);       //For random replacement policies
 }
 
 /*
  * Add a line to a given cache set.
  */
-static CacheLine *cache_set_add(const Cache& cache, CacheSet& cache_set, intptr_t address, intptr_t tag)
+static CacheLine *cache_set_add(Cache& cache, CacheSet& cache_set, intptr_t address, intptr_t tag, CacheLine* victim)
 {
     /*
      * First locate the cache line to use.
      */
     CacheLine *line = find_available_cache_line(cache, cache_set);
+
+    /*
+     * Keep the line being replaced, in case it needs writing back.
+     */
+    *victim = *line;
    
     /*
      * Now set it up.
@@ -244,6 +346,59 @@ void Cache::update(int warp_id,int inst){
 }
 
 
+/*
+ * Accounts for traffic to memory and passes it on to any attached levels.
+ */
+void Cache::to_memory(unsigned long address, bool read, unsigned int bytes){
+    if(read)
+      stats.addDramRead(bytes);
+    else
+      stats.addDramWrite(bytes,line_size);
+
+    for(unsigned int i=0;i<next_levels.size();i++){
+      next_levels[i]->request(address,read,bytes);
+    }
+}
+
+void Cache::flush_writes(){
+    for(unsigned int i=0;i<pending_writes.size();i++){
+      to_memory(pending_writes[i].first,false,pending_writes[i].second);
+    }
+    pending_writes.clear();
+    pending_stores = 0;
+}
+
+void Cache::flush_writes(int warp_id, int inst){
+    if(!pending_writes.empty() && (warp_id != pending_id || inst != pending_inst || pending_stores >= warp_size))
+      flush_writes();
+}
+
+/*
+ * If the evicted line was dirty, the whole line is written back to memory.
+ */
+void Cache::write_back(const CacheLine& victim, int set_index){
+    if(victim.state != CacheLine::MODIFIED)
+      return;
+
+    unsigned long address = (unsigned long)victim.tag << tag_shift;
+    if(index_function == CACHE_INDEX_MODULO)
+      address |= (unsigned long)set_index << cache_index_shift;
+
+    stats.incrementWriteBacks();
+    to_memory(address,false,line_size);
+}
+
+void Cache::flush_dirty(){
+    for(unsigned int s=0;s<num_sets;s++){
+      for(unsigned int i=0;i<associativity;i++){
+        CacheLine* line = sets[s].lines[i];
+        write_back(*line,s);
+        if(line->state == CacheLine::MODIFIED)
+          line->state = CacheLine::VALID;
+      }
+    }
+}
+
 /*
  *  Cache write from thread t_id, at instruction inst to address 
  */
@@ -253,7 +408,7 @@ void Cache::write(unsigned long address,int warp_id, int inst){
  
    
     //get set index, tag, and line offest from address
-    int set_index = (address >> cache_index_shift) & cache_index_mask;
+    int set_index = get_set(address);
     intptr_t tag = address >> tag_shift;
 
   
@@ -265,60 +420,62 @@ void Cache::write(unsigned long address,int warp_id, int inst){
     
     //update find stack distance of cache line
     unsigned int stack_dist = stats.stackRef(tag,set_index);
+
+    //if cache line hasn't been accessed this warp
+    bool first_in_warp = !(warp_counter > stack_dist);
+
+    CacheLine victim;
+    unsigned long line_addr = address & ~(unsigned long)line_offset_mask;
   
-   
-    //CASE: Write through, no allocate
-    if(write_policy == CACHE_WRITEPOLICY_WTNA){
-       if(matching_line == NULL){   //Write Miss
+    if(matching_line == NULL){   //Write Miss
+       if(first_in_warp){
+          stats.incrementWrites();
+          stats.incrementWriteMisses();
+       }
 
-         //if cache line hasn't been accessed this warp
-         if(!(warp_counter > stack_dist)){                
-            stats.incrementWrites();
-            stats.incrementWriteMisses();
-         }
+       //CASE: Write allocate, line is fetched from memory before being written
+       if(write_policy == CACHE_WRITEPOLICY_WBWA || write_policy == CACHE_WRITEPOLICY_WTWA){
+          matching_line = cache_set_add(*this,cache_set,address, tag, &victim);
 
-        }
-        else{                                            //Write hit
-        matching_line->ctr = matching_line->ctr + 1;
-         
-      
-        //if cache line hasn't been accessed this warp
-        if(!(warp_counter > stack_dist)){
-            stats.incrementWrites();
-        }
+          //Line is dirty, needs to be written back to memory
+          write_back(victim,set_index);
+
+          if(first_in_warp)
+             to_memory(line_addr,true,line_size);
        }
     }
-    //CASE: Write back allocate
-    else{
-       if(matching_line == NULL){                    //Write miss
-        
-         //if cache line hasn't been accessed this warp
-         if(!(warp_counter > stack_dist)){      
-            stats.incrementWrites();
-            stats.incrementWriteMisses();
-          }
-
-         //find line for write
-         matching_line = cache_set_add(*this,cache_set,address, tag);
+    else{                         //Write hit
+       if(first_in_warp)
+          stats.incrementWrites();
          
-         //Line is dirty, needs to be written back to memory
-        if(matching_line->state == CacheLine::MODIFIED){
-            stats.incrementWriteBacks();
-        }
+       matching_line->ctr = matching_line->ctr + 1;
+    }
 
-       }
-       else{   //Write hit
-        
-          //if cache line hasn't been accessed this warp
-          if(!(warp_counter > stack_dist)){
-              stats.incrementWrites();
-          }
-         
-          matching_line->ctr = matching_line->ctr + 1;
-       
-       }
+    //CASE: Write back allocate, line is dirty until evicted
+    if(write_policy == CACHE_WRITEPOLICY_WBWA){
        matching_line->state = CacheLine::MODIFIED;            //Set to dirty
     }
+    //CASE: Write through, the thread's word goes to memory with the
+    //other words the warp instruction stores to the line
+    else{
+       flush_writes(warp_id,inst);
+       pending_id = warp_id;
+       pending_inst = inst;
+       ++pending_stores;
+
+       unsigned int p = 0;
+       while(p < pending_writes.size() && pending_writes[p].first != line_addr)
+         p++;
+
+       if(p < pending_writes.size())
+         pending_writes[p].second += WORD_SIZE;
+       else
+         pending_writes.push_back(std::make_pair(line_addr,WORD_SIZE));
+
+       //CASE: Write evict, a store invalidates any cached copy
+       if(write_policy == CACHE_WRITEPOLICY_WE && matching_line != NULL)
+          matching_line->state = CacheLine::INVALID;
+    }
      
    
     //update details of previous access
@@ -338,7 +495,7 @@ void Cache::read(unsigned long address,int warp_id,int inst)
     /*
      use address to get line offset, tag, and set index
    */
-    int set_index = (address >> cache_index_shift) & cache_index_mask;
+    int set_index = get_set(address);
     intptr_t tag = address >> tag_shift;
 
     //finds cache set of access
@@ -349,62 +506,30 @@ void Cache::read(unsigned long address,int warp_id,int inst)
     
     //finds stack distance of cache line and updates stack distance histogram
     unsigned int stack_dist = stats.stackRef(tag,set_index);
-    
-    //CASE: Write through no-allocate
-    if(write_policy == CACHE_WRITEPOLICY_WTNA){
-        if(matching_line == NULL){                         //Read miss
-           matching_line = cache_set_add(*this,cache_set,address, tag);
-      
 
-          //if line has not been accessed this warp
-          if(!(warp_counter > stack_dist)){
-              stats.incrementReads();
-              stats.incrementReadMisses(stack_dist,num_sets * associativity);
-          }
-          
+    //if line has not been accessed this warp
+    bool first_in_warp = !(warp_counter > stack_dist);
 
-        }
-        else{    //Read hit
-          
-          //if line has not been accessed this warp
-          if(!(warp_counter > stack_dist)){
- 
-             stats.incrementReads();
-          }
-          
-           matching_line->ctr = matching_line->ctr + 1;
-        }
-
-    }
-    //CASE: Write back allocate
-    else{
-        if(matching_line == NULL){                     //Read miss
-         
-        
-         //if line has not been accessed this warp
-         if(!(warp_counter > stack_dist)){
-           stats.incrementReads();
-           stats.incrementReadMisses(stack_dist,num_sets * associativity);
-         }
-        
-         matching_line = cache_set_add(*this,cache_set,address, tag);
-        
-         //cache line is dirty and needs to be written back
-         if(matching_line->state == CacheLine::MODIFIED){
-              stats.incrementWriteBacks();
-         }
+    CacheLine victim;
+    unsigned long line_addr = address & ~(unsigned long)line_offset_mask;
+    
+    if(matching_line == NULL){                         //Read miss
+       if(first_in_warp){
+          stats.incrementReads();
+          stats.incrementReadMisses(stack_dist,num_sets * associativity);
+          to_memory(line_addr,true,line_size);
+       }
 
-           matching_line->state = CacheLine::VALID;              //Set line to valid
-        }
-        else{     
-         
-          //if line has not been accessed this warp
-          if(!(warp_counter > stack_dist)){
-            stats.incrementReads();
-          }
+       matching_line = cache_set_add(*this,cache_set,address, tag, &victim);
 
-          matching_line->ctr = matching_line->ctr + 1;
-        }
+       //cache line is dirty and needs to be written back
+       write_back(victim,set_index);
+    }
+    else{    //Read hit
+       if(first_in_warp)
+          stats.incrementReads();
+          
+       matching_line->ctr = matching_line->ctr + 1;
     }
 
     
@@ -414,4 +539,3 @@ void Cache::read(unsigned long address,int warp_id,int inst)
     last_id = warp_id;
 
 }
-
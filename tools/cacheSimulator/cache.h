@@ -7,6 +7,9 @@
 #define CACHE_H
 #include <cstdlib>
 #include "stats.h"
+#include "common.h"
+#include <random>
+#include <utility>
 #include <vector>
 
 /*
@@ -24,6 +27,52 @@ const unsigned int CACHE_REPLACEMENTPOLICY_LFU =3;     //LESASR FREQUENTLY USED
 
 const unsigned int CACHE_WRITEPOLICY_WBWA   = 0;       //WRITE BACK WRITE ALLOCATE
 const unsigned int CACHE_WRITEPOLICY_WTNA   = 1;        //WRITE THROUGH NO-ALLOCATE
+const unsigned int CACHE_WRITEPOLICY_WE     = 2;        //WRITE EVICT, stores invalidate the line (FERMI L1)
+const unsigned int CACHE_WRITEPOLICY_WTWA   = 3;        //WRITE THROUGH WRITE ALLOCATE
+
+/*
+ * Bytes stored by a single thread's write. Traces assume 4 byte elements,
+ * so a write through request carries this many bytes for each thread of
+ * the warp instruction storing to the line.
+ */
+const unsigned int WORD_SIZE = 4;
+
+/*
+ * Set index functions.
+ */
+
+const unsigned int CACHE_INDEX_MODULO  = 0;     //Block address modulo the number of sets
+const unsigned int CACHE_INDEX_XOR     = 1;     //Block address folded onto the index bits with XOR
+const unsigned int CACHE_INDEX_PERMUTE = 2;     //Index bits picked from anywhere in the block address
+const unsigned int CACHE_INDEX_PRIME   = 3;     //Block address modulo the largest prime number of sets
+const unsigned int CACHE_INDEX_MATRIX  = 4;     //Each index bit is the parity of masked block address bits
+
+/*
+ * How addresses are mapped onto sets. With any function but modulo the
+ * tag holds the whole block address, as the set no longer identifies
+ * any of its bits.
+ */
+struct IndexFunction
+{
+   IndexFunction():type(CACHE_INDEX_MODULO){}
+
+   unsigned int type;
+   std::vector<unsigned int> bits;      //PERMUTE: block address bit of each index bit, lowest first
+   std::vector<unsigned long> rows;     //MATRIX: block address mask of each index bit, lowest first
+};
+
+
+//Parameters needed to build a cache, so identical caches can be created
+//for executions simulated in parallel.
+struct CacheConfig
+{
+   unsigned int num_lines;
+   unsigned int line_size;
+   unsigned int associativity;
+   unsigned int rep_policy;
+   unsigned int write_policy;
+   IndexFunction index;
+};
 
 
 //Class used to store a single cache line.
@@ -77,6 +126,35 @@ class Cache
 	
    void update(int warp_id,int inst);
 
+   void write_back(const CacheLine& victim, int set_index);
+
+   void to_memory(unsigned long address, bool read, unsigned int bytes);
+
+   //Write through stores of the current warp instruction, gathered into
+   //one request per line: line address and bytes stored to it
+   std::vector<std::pair<unsigned long,unsigned int> > pending_writes;
+   int pending_id;                  //Warp of the gathered stores
+   int pending_inst;                //Instruction of the gathered stores
+   unsigned int pending_stores;     //Stores gathered
+
+   void set_index_function(const IndexFunction& function);
+
+   unsigned int index_function;             //One of CACHE_INDEX_*
+   unsigned int index_bits;                 //Bits in a set index
+   unsigned int prime;                      //Sets used by prime modulo
+   unsigned long long prime_inverse;        //2^64 / prime, rounded up, so modulo needs no division
+
+   //Linear hashes (permutations and XOR matrices) are evaluated a byte of
+   //the block address at a time: entry [byte][value] holds the index bits
+   //that byte contributes.
+   std::vector<unsigned int> hash_table;
+   unsigned int hash_bytes;
+
+   std::vector<MemoryLevel*> next_levels;   //Levels receiving traffic from this cache
+
+   Cache(const Cache&);               //Not copyable, sets own their lines
+   Cache& operator=(const Cache&);
+
   public:
 
    /*
@@ -91,7 +169,35 @@ class Cache
 
     void reset_memory(){ warp_counter=0;last_id=0;last_inst=0;}
 
+    /*
+     * Sends the write through stores gathered for a warp instruction on
+     * to memory, a request per line carrying the bytes stored to it.
+     * Given the next access, only sends them if it starts a new warp
+     * instruction, so the traffic is attributed to the stores.
+    */
+    void flush_writes();
+    void flush_writes(int warp_id, int inst);
+
+    /*
+     * Writes every dirty line back to memory, leaving it valid and clean.
+    */
+    void flush_dirty();
+
+    /*
+     * Send traffic leaving the cache on to another level of the hierarchy.
+    */
+    void attach(MemoryLevel* level){ next_levels.push_back(level);}
+
     Cache(unsigned int num_lines, unsigned int line_size, unsigned int associativity, unsigned int rep_policy, unsigned int write_policy);
+
+    Cache(const CacheConfig& config);
+
+    /*
+     * Set an address maps onto.
+    */
+    unsigned int get_set(unsigned long address) const;
+
+    ~Cache();
     
     unsigned int num_sets;             // Number of sets in the cache. 
 
@@ -117,12 +223,44 @@ class Cache
 
     unsigned int warp_size;            // Size of a warp 
 
+    std::mt19937 rng;                  // Random replacement victims
+
 };
 
 
 
 
 
+inline unsigned int Cache::get_set(unsigned long address) const{
+    unsigned long block = address >> cache_index_shift;
+
+    switch(index_function){
+      case CACHE_INDEX_XOR:{
+        unsigned long set = 0;
+        for(; block; block >>= index_bits){
+          set ^= block;
+        }
+        return set & cache_index_mask;
+      }
+
+      case CACHE_INDEX_PRIME:
+        if(block >> 32)
+          return block % prime;
+        return ((unsigned __int128)(prime_inverse * block) * prime) >> 64;
+
+      case CACHE_INDEX_PERMUTE:
+      case CACHE_INDEX_MATRIX:{
+        unsigned int set = 0;
+        for(unsigned int b=0;b<hash_bytes;b++){
+          set ^= hash_table[(b << 8) | ((block >> (b * 8)) & 0xFF)];
+        }
+        return set;
+      }
+
+      default:
+        return block & cache_index_mask;
+    }
+}
 
 
 unsigned int ceiling(unsigned int a, unsigned int b);
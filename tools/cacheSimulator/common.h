@@ -1,26 +1,46 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <random>
 #include <vector>
 
-std::vector<unsigned int>get_workgroups(unsigned int warp_size,unsigned int total_wk);
+std::vector<unsigned int>get_workgroups(unsigned int total_wk,std::mt19937& rng);
 
 
 const unsigned int CORES = 15;  //Number of cores on GTX 480 architecture simulated against
 
 unsigned int ceiling(unsigned int a, unsigned int b);
 
+/*
+ * Bits of an access's op field.
+ */
+const unsigned int OP_READ  = 1;   //Read rather than write
+const unsigned int OP_LOCAL = 2;   //Access to local rather than global memory
+const unsigned int OP_READONLY = 4;   //Load of data the kernel never writes
+
 class Entry{
  public:
-	Entry(unsigned int addr,bool _op,unsigned int wk,unsigned int warp,unsigned int i):
+	Entry():address(0),op(0),wk_id(0),warp_id(0),inst(0) {}
+	Entry(unsigned int addr,unsigned int _op,unsigned int wk,unsigned int warp,unsigned int i):
 	      address(addr),op(_op),wk_id(wk),warp_id(warp),inst(i) {}
 	
 	unsigned int address;
-	bool op;
+	unsigned int op;
 	unsigned int wk_id;
 	unsigned int warp_id; 
 	unsigned int inst;
 
 };
 
+/*
+ * Next level of the memory hierarchy. Receives the line fills, write backs
+ * and write through traffic leaving a cache.
+ */
+class MemoryLevel{
+ public:
+	virtual ~MemoryLevel() {}
+
+	virtual void request(unsigned long address,bool read,unsigned int bytes) = 0;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,249 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <condition_variable>
+#include <csignal>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "daemon.h"
+#include "parse.h"
+#include "sim.h"
+
+
+const unsigned int MAX_REQUEST = 64 * 1024;   //Longest request line accepted
+
+typedef std::map<std::string,TRACE_VEC> TRACE_MAP;
+
+
+/*
+ *  Opens a Unix domain socket for the path, returns -1 on failure
+*/
+static int open_socket(const char* path, sockaddr_un& addr){
+  if(strlen(path) >= sizeof(addr.sun_path)){
+    std::cout << "socket path too long "<< path <<std::endl;
+    return -1;
+  }
+
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path,path);
+
+  return socket(AF_UNIX,SOCK_STREAM,0);
+}
+
+/*
+ *  Writes the whole of a string to a socket
+*/
+static void send_all(int fd, const std::string& text){
+  size_t sent = 0;
+  while(sent < text.size()){
+    ssize_t n = write(fd,text.data() + sent,text.size() - sent);
+    if(n <= 0)
+      return;
+    sent += n;
+  }
+}
+
+/*
+ *  Runs a single request against the resident traces, returning the reply
+*/
+static std::string serve(const TRACE_MAP& traces, const std::string& request){
+
+  //Split request into arguments, as the shell would for a normal run
+  std::vector<std::string> words;
+  std::istringstream line(request);
+  std::string word;
+  words.push_back("cacheSim");
+  while(line >> word){
+    words.push_back(word);
+  }
+
+  std::vector<char*> argv;
+  for(unsigned int i=0;i<words.size();i++){
+    argv.push_back(&words[i][0]);
+  }
+
+  if(words.size() < 2)
+    return "error: empty request\n";
+
+  TRACE_MAP::const_iterator trace = traces.find(words[1]);
+  if(trace == traces.end())
+    return "error: trace " + words[1] + " is not loaded\n";
+
+  CacheConfig config;
+  Options opts;
+  if(parse_config(argv.size(),&argv[0],2,config,opts) == -1)
+    return "error: invalid configuration\n";
+
+  //Traces were parsed whole when the daemon started
+  if(opts.filter.enabled())
+    return "error: -filter applies while parsing, it cannot be used with the daemon\n";
+
+  //The daemon owns no output files, and serves each request on one thread
+  opts.miss_file.clear();
+  opts.working_set.window = 0;
+  opts.threads = 0;
+  opts.replicas = 1;
+
+  Simulator sim(config,opts);
+  for(unsigned int i=0;i<trace->second.size();i++){
+    sim.run(*trace->second[i],i);
+  }
+
+  std::ostringstream reply;
+  sim.report().print(reply,opts);
+  return reply.str();
+}
+
+/*
+ *  Reads a request line from a client and sends back the reply
+*/
+static void handle(const TRACE_MAP& traces, int fd){
+  std::string request;
+  char buffer[4096];
+
+  while(request.find('\n') == std::string::npos && request.size() < MAX_REQUEST){
+    ssize_t n = read(fd,buffer,sizeof(buffer));
+    if(n <= 0)
+      break;
+    request.append(buffer,n);
+  }
+
+  send_all(fd,serve(traces,request.substr(0,request.find('\n'))));
+}
+
+
+int run_daemon(int argc, char* argv[], int first){
+
+  if(argc < first + 2){
+    std::cout << "usage: "<< argv[0] <<" -daemon socket [-p threads] trace...\n";
+    return 0;
+  }
+
+  const char* path = argv[first++];
+
+  unsigned int threads = std::thread::hardware_concurrency();
+  if(first + 1 < argc && strcmp("-p",argv[first])==0){
+    threads = atoi(argv[first + 1]);
+    first += 2;
+  }
+  if(threads == 0)
+    threads = 1;
+
+  //Parse every trace once, they stay resident for all requests
+  TRACE_MAP traces;
+  for(int i=first;i<argc;i++){
+    std::ifstream input(argv[i]);
+    if(!input.is_open()){
+      std::cout << "unable to open file "<< argv[i] <<std::endl;
+      return 0;
+    }
+    traces[argv[i]] = parse(input);
+    std::cout << "Loaded "<< argv[i] <<": "<< traces[argv[i]].size() <<" executions"<<std::endl;
+  }
+
+  //A client hanging up early must not end the daemon
+  signal(SIGPIPE,SIG_IGN);
+
+  sockaddr_un addr;
+  int server = open_socket(path,addr);
+  unlink(path);
+  if(server == -1 || bind(server,(sockaddr*)&addr,sizeof(addr)) == -1 || listen(server,SOMAXCONN) == -1){
+    std::cout << "unable to listen on "<< path <<std::endl;
+    return 0;
+  }
+
+  //Accepted connections wait here for a worker
+  std::queue<int> pending;
+  std::mutex lock;
+  std::condition_variable ready;
+
+  auto worker = [&](){
+    while(true){
+      int fd;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        ready.wait(guard,[&](){ return !pending.empty();});
+        fd = pending.front();
+        pending.pop();
+      }
+      handle(traces,fd);
+      close(fd);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for(unsigned int t=0;t<threads;t++){
+    pool.push_back(std::thread(worker));
+  }
+
+  std::cout << "Serving on "<< path <<" with "<< threads <<" threads"<<std::endl;
+
+  while(true){
+    int fd = accept(server,NULL,NULL);
+    if(fd == -1)
+      continue;
+
+    std::lock_guard<std::mutex> guard(lock);
+    pending.push(fd);
+    ready.notify_one();
+  }
+}
+
+
+int run_client(int argc, char* argv[], int first){
+
+  if(argc < first + 2){
+    std::cout << "usage: "<< argv[0] <<" -client socket trace size line size associativity replacement write [options]\n";
+    return 0;
+  }
+
+  sockaddr_un addr;
+  int fd = open_socket(argv[first],addr);
+  if(fd == -1 || connect(fd,(sockaddr*)&addr,sizeof(addr)) == -1){
+    std::cout << "unable to connect to "<< argv[first] <<std::endl;
+    return 0;
+  }
+
+  std::string request;
+  for(int i=first + 1;i<argc;i++){
+    request += argv[i];
+    request += (i + 1 < argc) ? " " : "\n";
+  }
+  send_all(fd,request);
+
+  char buffer[4096];
+  ssize_t n;
+  while((n = read(fd,buffer,sizeof(buffer))) > 0){
+    std::cout.write(buffer,n);
+  }
+
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * daemon.h
+ *
+ * Resident mode of the simulator. Traces are parsed once and kept in
+ * memory, and simulations of them are served to clients over a Unix
+ * domain socket.
+ *
+ * A request is one line holding the same arguments as a normal run,
+ * starting with the trace file as named when the daemon was started.
+ * The reply is the report of the run, after which the connection closes.
+ */
+#ifndef DAEMON_H
+#define DAEMON_H
+
+/*
+ *  cacheSim -daemon socket [-p threads] trace...
+ *  Loads the traces and serves requests until killed.
+*/
+int run_daemon(int argc, char* argv[], int first);
+
+/*
+ *  cacheSim -client socket trace size line size associativity replacement write [options]
+ *  Sends a request to a daemon and prints the reply.
+*/
+int run_client(int argc, char* argv[], int first);
+
+#endif
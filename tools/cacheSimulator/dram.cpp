@@ -0,0 +1,155 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include "dram.h"
+
+
+Dram::Dram(const DramConfig& c):config(c){
+
+  open_row.assign(config.channels * config.banks,-1);
+  channel_requests.assign(config.channels,0);
+  channel_bytes.assign(config.channels,0);
+
+  clear_counts();
+}
+
+void Dram::clear_counts(){
+  reads = 0;
+  writes = 0;
+  row_hits = 0;
+  row_misses = 0;
+  row_conflicts = 0;
+
+  channel_requests.assign(config.channels,0);
+  channel_bytes.assign(config.channels,0);
+}
+
+/*
+ * Maps the address onto a channel, bank and row, then updates
+ * the row buffer of that bank.
+*/
+void Dram::request(unsigned long address, bool read, unsigned int bytes){
+
+  unsigned long block = address / config.interleave;
+  unsigned int channel = block % config.channels;
+
+  //Blocks within the channel, a row holds several of them
+  unsigned long local = block / config.channels;
+  unsigned long row_blocks = config.row_size / config.interleave;
+  if(row_blocks == 0)
+    row_blocks = 1;
+
+  unsigned long page = local / row_blocks;
+  unsigned int bank = page % config.banks;
+  long row = page / config.banks;
+
+  if(read)
+    ++reads;
+  else
+    ++writes;
+
+  ++channel_requests[channel];
+  channel_bytes[channel] += bytes;
+
+  long& open = open_row[channel * config.banks + bank];
+
+  if(open == row)
+    ++row_hits;
+  else if(open == -1)
+    ++row_misses;
+  else
+    ++row_conflicts;
+
+  open = (config.page_policy == DRAM_PAGE_OPEN) ? row : -1;
+}
+
+Dram& Dram::operator+= (const Dram& right){
+  reads += right.reads;
+  writes += right.writes;
+  row_hits += right.row_hits;
+  row_misses += right.row_misses;
+  row_conflicts += right.row_conflicts;
+
+  for(unsigned int i=0;i<channel_requests.size() && i<right.channel_requests.size();i++){
+    channel_requests[i] += right.channel_requests[i];
+    channel_bytes[i] += right.channel_bytes[i];
+  }
+  return *this;
+}
+
+/*
+ * returns the fraction of requests served from an open row
+*/
+double Dram::getRowHitRate() const{
+  unsigned long total = reads + writes;
+  if(total == 0)
+    return 0;
+  return ((double) row_hits / total);
+}
+
+/*
+ * returns the requests of the busiest channel over the mean requests
+ * per channel, 1 when traffic is perfectly spread
+*/
+double Dram::getChannelImbalance() const{
+  unsigned long total = reads + writes;
+  if(total == 0)
+    return 0;
+
+  unsigned long busiest = 0;
+  for(unsigned int i=0;i<channel_requests.size();i++){
+    if(channel_requests[i] > busiest)
+      busiest = channel_requests[i];
+  }
+
+  return ((double) busiest * channel_requests.size() / total);
+}
+
+void Dram::getValues(std::vector<NamedStat>& values) const{
+  values.push_back(NamedStat("dram_reads",reads));
+  values.push_back(NamedStat("dram_writes",writes));
+  values.push_back(NamedStat("row_hits",row_hits));
+  values.push_back(NamedStat("row_misses",row_misses));
+  values.push_back(NamedStat("row_conflicts",row_conflicts));
+  values.push_back(NamedStat("row_hit_rate",getRowHitRate()));
+  values.push_back(NamedStat("channel_imbalance",getChannelImbalance()));
+}
+
+std::ostream & operator<< (std::ostream & os, const Dram& right){
+  os<<"\n==================================\n";
+  os<<"DRAM\n";
+  os<<"==================================\n";
+  os<<"Read Requests:     "<<right.reads << std::endl;
+  os<<"Write Requests:    "<<right.writes << std::endl;
+  os<<"Row Hits:          "<<right.row_hits << std::endl;
+  os<<"Row Misses:        "<<right.row_misses << std::endl;
+  os<<"Row Conflicts:     "<<right.row_conflicts << std::endl;
+  os<<"Row Hit Rate:      "<<right.getRowHitRate() << std::endl;
+  os<<"Channel Imbalance: "<<right.getChannelImbalance() << std::endl;
+
+  for(unsigned int i=0;i<right.channel_requests.size();i++){
+    os<<"Channel "<< i <<":         "<<right.channel_requests[i] <<" requests, "
+      <<right.channel_bytes[i] <<" bytes"<< std::endl;
+  }
+  os<<std::endl;
+
+  return os;
+}
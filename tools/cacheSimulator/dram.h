@@ -0,0 +1,85 @@
+/*
+ * dram.h
+ *
+ * Model of the DRAM behind the last cache level. Requests are mapped onto
+ * channels, banks and rows, and each bank's row buffer is tracked so row
+ * locality and the balance of traffic across channels can be reported.
+ */
+#ifndef DRAM_H
+#define DRAM_H
+
+#include <iostream>
+#include <vector>
+
+#include "common.h"
+#include "stats.h"
+
+/*
+ * Page policies.
+ */
+
+const unsigned int DRAM_PAGE_OPEN   = 0;    //Row stays open until another row in the bank is needed
+const unsigned int DRAM_PAGE_CLOSED = 1;    //Row is closed after every access
+
+/*
+ * Address mapping and page policy of the DRAM.
+ *
+ * Consecutive blocks of 'interleave' bytes go to consecutive channels.
+ * Within a channel, blocks fill a row of 'row_size' bytes before moving
+ * to the next bank, and rows fill every bank before the row id increases.
+ */
+struct DramConfig
+{
+   unsigned int channels;
+   unsigned int banks;           //Banks per channel
+   unsigned int row_size;        //Bytes in a row
+   unsigned int interleave;      //Bytes mapped to a channel before moving to the next
+   unsigned int page_policy;
+};
+
+// Default configuration, loosely based on the GDDR5 partitions of a GTX 480
+const DramConfig DRAM_DEFAULT = {6, 16, 2048, 256, DRAM_PAGE_OPEN};
+
+
+class Dram : public MemoryLevel
+{
+  public:
+    Dram(const DramConfig& config);
+
+    /*
+     * Request of 'bytes' bytes at address from the cache above. Each is a
+     * whole transaction: a line filled or written back, or the stores of
+     * a warp instruction to a line, so rows and channels are counted per
+     * transaction rather than per thread.
+     */
+    void request(unsigned long address, bool read, unsigned int bytes);
+
+    // Zeroes the counters, leaving the open rows as they are
+    void clear_counts();
+
+    Dram& operator+= (const Dram& right);
+
+    friend std::ostream & operator<< (std::ostream & os, const Dram& right);
+
+    double getRowHitRate() const;
+    double getChannelImbalance() const;    //Busiest channel's requests over the mean
+
+    // Every counter and rate, by name
+    void getValues(std::vector<NamedStat>& values) const;
+
+  private:
+    DramConfig config;
+
+    std::vector<long> open_row;             //Open row of each bank, -1 when closed
+
+    unsigned long reads;                    //Read requests
+    unsigned long writes;                   //Write requests
+    unsigned long row_hits;                 //Requests to the open row
+    unsigned long row_misses;               //Requests to a bank with no open row
+    unsigned long row_conflicts;            //Requests which had to close another row
+
+    std::vector<unsigned long> channel_requests;
+    std::vector<unsigned long long> channel_bytes;
+};
+
+#endif
@@ -0,0 +1,94 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <unordered_map>
+
+#include "interleave.h"
+
+
+Interleaver::Interleaver(const OccupancyConfig& c):config(c),launched(0),resident(0){}
+
+void Interleaver::load(const Execution& exec, const std::vector<unsigned int>& workgroups){
+
+  queues.assign(workgroups.size(),std::vector<WarpQueue>());
+
+  //Position of each sampled workgroup in launch order
+  std::unordered_map<unsigned int,unsigned int> order;
+  for(unsigned int w=0;w<workgroups.size();w++){
+    order[workgroups[w]] = w;
+  }
+
+  //Queue of each warp seen, as workgroup and position within it
+  std::unordered_map<unsigned int,std::pair<unsigned int,unsigned int> > warps;
+
+  //A warp instruction is a run of accesses with the same warp and instruction
+  unsigned int last_warp = ~0u;
+  unsigned int last_inst = ~0u;
+
+  Execution::Reader reader(exec);
+  Entry e;
+  while(reader.next(e)){
+    std::unordered_map<unsigned int,unsigned int>::iterator wk = order.find(e.wk_id);
+    if(wk == order.end())
+      continue;
+
+    std::vector<WarpQueue>& wk_queues = queues[wk->second];
+
+    std::unordered_map<unsigned int,std::pair<unsigned int,unsigned int> >::iterator found = warps.find(e.warp_id);
+    if(found == warps.end()){
+      found = warps.insert(std::make_pair(e.warp_id,std::make_pair(wk->second,(unsigned int)wk_queues.size()))).first;
+      wk_queues.push_back(WarpQueue());
+      wk_queues.back().next = 0;
+      wk_queues.back().ready = 0;
+    }
+
+    WarpQueue& warp = queues[found->second.first][found->second.second];
+    if(e.warp_id != last_warp || e.inst != last_inst)
+      warp.starts.push_back(warp.accesses.size());
+    warp.accesses.push_back(e);
+
+    last_warp = e.warp_id;
+    last_inst = e.inst;
+  }
+
+  warps_left.assign(workgroups.size(),0);
+  for(unsigned int w=0;w<queues.size();w++){
+    warps_left[w] = queues[w].size();
+  }
+}
+
+/*
+ * Brings workgroups onto the core until it is full, or none are left.
+ * Workgroups without accesses finish as soon as they launch.
+*/
+void Interleaver::launch(){
+  while(resident < config.resident && launched < queues.size()){
+    unsigned int w = launched++;
+    if(queues[w].empty())
+      continue;
+
+    ++resident;
+    for(unsigned int i=0;i<queues[w].size();i++){
+      Active a = {&queues[w][i],w};
+      active.push_back(a);
+    }
+  }
+}
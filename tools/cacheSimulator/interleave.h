@@ -0,0 +1,167 @@
+/*
+ * interleave.h
+ *
+ * Replay of the workgroups sampled on a core with several of them resident
+ * at once, as on a real SM. The warps of the resident workgroups take turns
+ * issuing their memory instructions, picked by a warp scheduling policy,
+ * and a workgroup leaves the core when all its warps have finished.
+ */
+#ifndef INTERLEAVE_H
+#define INTERLEAVE_H
+
+#include <vector>
+
+#include "common.h"
+#include "store.h"
+
+/*
+ * Warp scheduling policies.
+ */
+
+const unsigned int WARP_POLICY_LRR = 0;    //Loose round robin over the warps ready to issue
+const unsigned int WARP_POLICY_GTO = 1;    //Greedy then oldest, a warp issues until it stalls
+
+// Issue slots a warp waits after a cache miss, about the DRAM latency in
+// cycles of a GTX 480 when one warp instruction issues per cycle
+const unsigned int MISS_LATENCY = 400;
+
+struct OccupancyConfig
+{
+   unsigned int resident;      //Workgroups resident on the core, 0 to replay them one after another
+   unsigned int policy;
+   unsigned int latency;       //Issue slots a warp stalls for after a miss
+};
+
+
+//Memory instructions of a warp in program order
+struct WarpQueue
+{
+   std::vector<Entry> accesses;
+   std::vector<unsigned int> starts;   //First access of each warp instruction
+
+   unsigned int next;                  //Next warp instruction to issue
+   unsigned long ready;                //Issue slot from which the warp can issue again
+};
+
+
+class Interleaver
+{
+  public:
+    Interleaver(const OccupancyConfig& config);
+
+    /*
+     * Splits the accesses of the workgroups into the warp instructions
+     * of each warp, in a single pass over the execution.
+     */
+    void load(const Execution& exec, const std::vector<unsigned int>& workgroups);
+
+    /*
+     * Issues every warp instruction loaded. Workgroups are launched in the
+     * order given to load. issue(first,last) replays a warp instruction's
+     * accesses and returns true if any of them missed, stalling the warp.
+     */
+    template<class Issue>
+    void run(Issue issue);
+
+  private:
+    void launch();
+
+    OccupancyConfig config;
+
+    std::vector<std::vector<WarpQueue> > queues;   //Warps of each workgroup, in order of first access
+
+    unsigned int launched;                  //Workgroups launched so far
+    std::vector<unsigned int> warps_left;   //Unfinished warps of each workgroup
+    unsigned int resident;                  //Workgroups currently on the core
+
+    struct Active
+    {
+       WarpQueue* warp;
+       unsigned int workgroup;
+    };
+    std::vector<Active> active;             //Unfinished warps of resident workgroups, oldest first
+};
+
+
+template<class Issue>
+void Interleaver::run(Issue issue){
+
+  launched = 0;
+  resident = 0;
+  active.clear();
+  launch();
+
+  unsigned long slot = 0;      //Issue slots elapsed
+  unsigned int current = 0;    //Warp which issued last
+
+  while(!active.empty()){
+
+    //Pick a ready warp
+    unsigned int picked = active.size();
+    if(config.policy == WARP_POLICY_GTO){
+      if(current < active.size() && active[current].warp->ready <= slot)
+        picked = current;
+      else{
+        for(unsigned int i=0;i<active.size() && picked == active.size();i++){
+          if(active[i].warp->ready <= slot)
+            picked = i;
+        }
+      }
+    }
+    else{
+      for(unsigned int n=1;n<=active.size() && picked == active.size();n++){
+        unsigned int i = (current + n) % active.size();
+        if(active[i].warp->ready <= slot)
+          picked = i;
+      }
+    }
+
+    //Every warp is stalled, skip to the first to wake up
+    if(picked == active.size()){
+      unsigned long wake = active[0].warp->ready;
+      for(unsigned int i=1;i<active.size();i++){
+        if(active[i].warp->ready < wake)
+          wake = active[i].warp->ready;
+      }
+      slot = wake;
+      continue;
+    }
+
+    WarpQueue& warp = *active[picked].warp;
+    const Entry* accesses = &warp.accesses[0];
+    unsigned int first = warp.starts[warp.next];
+    unsigned int last = (warp.next + 1 < warp.starts.size()) ? warp.starts[warp.next + 1] : warp.accesses.size();
+
+    bool missed = issue(accesses + first,accesses + last);
+    ++slot;
+    ++warp.next;
+
+    if(missed)
+      warp.ready = slot + config.latency;
+
+    current = picked;
+
+    //Finished warp leaves, and its workgroup once all its warps are done
+    if(warp.next == warp.starts.size()){
+      unsigned int workgroup = active[picked].workgroup;
+      active.erase(active.begin() + picked);
+
+      if(--warps_left[workgroup] == 0){
+        --resident;
+        launch();
+      }
+
+      //Round robin carries on from the warp after the one removed,
+      //greedy starts again from the oldest warp. Set once any new
+      //warps are launched, as they are appended to the active warps.
+      if(config.policy == WARP_POLICY_GTO)
+        current = active.size();
+      else if(picked == 0)
+        current = active.empty() ? 0 : active.size() - 1;
+      else
+        current = picked - 1;
+    }
+  }
+}
+
+#endif
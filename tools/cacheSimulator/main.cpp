@@ -20,81 +20,153 @@ along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
 */
 
 #include <algorithm>  
+#include <atomic>
+#include <thread>
 
 #include "parse.h"
 #include "stats.h"
 #include "cache.h"
 #include "common.h"
+#include "sim.h"
+#include "daemon.h"
 
 
-//calculate workgroups to process based on total number of workgroups
-std::vector<unsigned int>get_workgroups(unsigned int warp_size,unsigned int total_wk){
+/*
+ *  Runs trace through simulator
+*/
+void exec_trace(TRACE_VEC& executions,Simulator& sim,std::ofstream& miss_out,std::ofstream& ws_out){
+
+  for(unsigned int n=0;n<executions.size();n++){
+      std::cout <<"\nExecuting Trace " << n << " of "<<executions.size()<<std::endl;
+      sim.run(*executions[n],n);
+      sim.print_tlb(std::cout);
+      miss_out << sim.take_misses();
+      ws_out << sim.take_working_set();
+  }
+}
 
-  std::vector<unsigned int> workgroups;
+/*
+ *  Simulates executions concurrently, each on a cache of its own. Caches
+ *  start cold, unless a warm prefix is given, in which case the preceding
+ *  executions are replayed first without counting their stats.
+ *  Returns the results of every execution in execution order.
+*/
+std::vector<Report> exec_parallel(TRACE_VEC& executions,const CacheConfig& config,const Options& opts,
+                                  std::vector<std::string>& misses,std::vector<std::string>& series){
 
-  //Seed rand() function
-  srand(time(NULL));
+  std::vector<Report> results(executions.size(),Report(opts));
+  misses.assign(executions.size(),std::string());
+  series.assign(executions.size(),std::string());
+  std::atomic<unsigned int> next(0);
 
-  //calculate how many workgroups will be processed on each core
-  unsigned int sim_num = ceiling(total_wk,CORES);
+  auto worker = [&](){
+    unsigned int i;
+    while((i = next++) < executions.size()){
+      Simulator sim(config,opts);
 
-  // if only one workgroup per core, process first workgroup
-  if(sim_num == 1){
-  // std::cout << "wk group zero \n";
-   workgroups.push_back(0);
-   return workgroups;
-  }
+      unsigned int first = 0;
+      if(opts.warm != WARM_ALL && i > (unsigned int)opts.warm)
+        first = i - opts.warm;
 
-  //Picks workgroups at random to simulate, provided they are not duplicates 
-  for(unsigned int i=0;i<sim_num;i++){
-      unsigned int added = rand() % total_wk;
-      while(std::find(workgroups.begin(),workgroups.end(),added) != workgroups.end() ){
-          added = rand() % total_wk;
+      for(unsigned int p=first;p<i;p++){
+        sim.run(*executions[p],p);
       }
-      workgroups.push_back(added);
+      sim.clear_counts();
+
+      sim.run(*executions[i],i);
+      results[i] = sim.report();
+      misses[i] = sim.take_misses();
+      series[i] = sim.take_working_set();
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for(unsigned int t=0;t<opts.threads;t++){
+    pool.push_back(std::thread(worker));
+  }
+  for(unsigned int t=0;t<pool.size();t++){
+    pool[t].join();
   }
 
-  return workgroups;
-
+  return results;
 }
 
 /*
- *  Runs trace through simulator
+ *  Simulates independently sampled replicas of the whole trace concurrently.
+ *  Each replica draws its samples from its own random streams.
 */
-void exec_trace(TRACE_VEC& executions,Cache& cache){
-
-  unsigned int n=0;
-  for(TRACE_VEC::iterator iter = executions.begin(), end = executions.end(); iter != end; ++iter){
-      std::cout <<"\nExecuting Trace " << n++ << " of "<<executions.size()<<std::endl;
-      cache.warp_size = std::get<1>(*iter);
-      cache.reset_memory();
-
-      std::vector<unsigned int> workgroups = std::get<0>(*iter);
-      std::list<Entry> entries = std::get<2>(*iter);
-
-
-      for(unsigned int w=0;w<workgroups.size();w++){
-        //for every entry in workgroup
-        for( std::list<Entry>::iterator e_iter = entries.begin(), \
-           e_end = entries.end();e_iter!=e_end;++e_iter){  
-
-            //check if entry is in current workgroup
-            if(e_iter->wk_id == workgroups.at(w)){
-              //Process with simulator
-              if(e_iter->op==1)
-                cache.read(e_iter->address,e_iter->warp_id,e_iter->inst);        //Cache read
-              else
-                cache.write(e_iter->address,e_iter->warp_id,e_iter->inst);       //Cache write
-            }
-        }
+std::vector<Report> exec_replicas(TRACE_VEC& executions,const CacheConfig& config,const Options& opts,
+                                  std::string& misses,std::string& series){
+
+  std::vector<Report> results(opts.replicas,Report(opts));
+  std::atomic<unsigned int> next(0);
+
+  auto worker = [&](){
+    unsigned int r;
+    while((r = next++) < opts.replicas){
+      Simulator sim(config,opts,r);
+
+      for(unsigned int i=0;i<executions.size();i++){
+        sim.run(*executions[i],i);
+      }
+      results[r] = sim.report();
+
+      //Miss stream and working set of the first replica only
+      if(r == 0){
+        misses = sim.take_misses();
+        series = sim.take_working_set();
       }
+    }
+  };
+
+  unsigned int threads = opts.threads ? opts.threads : std::thread::hardware_concurrency();
+  std::vector<std::thread> pool;
+  for(unsigned int t=0;t<threads && t<opts.replicas;t++){
+    pool.push_back(std::thread(worker));
+  }
+  for(unsigned int t=0;t<pool.size();t++){
+    pool[t].join();
+  }
+
+  return results;
+}
+
+/*
+ *  Simulates each execution as soon as its end is appended to the input,
+ *  printing its results before waiting for the next one
+*/
+void exec_follow(std::ifstream& input,Simulator& sim,const Options& opts,std::ofstream& miss_out,
+                 std::ofstream& ws_out){
+
+  LineFollower lines(input,true,opts.follow_idle);
+  unsigned int n = 0;
+  while(std::unique_ptr<Execution> exec = parse_execution(lines,opts.filter)){
+    std::cout <<"\nExecuting Trace " << n <<std::endl;
+    sim.run(*exec,n);
+    sim.print_tlb(std::cout);
+
+    Report r = sim.report();
+    std::cout <<"Total so far: "<< r.stats.getNumAccess() <<" accesses, miss rate "
+              << r.stats.getTotalMissRate() <<std::endl;
+
+    miss_out << sim.take_misses();
+    miss_out.flush();
+    ws_out << sim.take_working_set();
+    ws_out.flush();
+    n++;
   }
 }
 
 
 int main(int argc, char *argv[]){
+
+  //Resident service, and the client used to query it
+  if(argc > 1 && strcmp("-daemon",argv[1])==0)
+    return run_daemon(argc,argv,2);
+  if(argc > 1 && strcmp("-client",argv[1])==0)
+    return run_client(argc,argv,2);
   
-  if(argc != 7){                      //Print help if wrong number of cli arguments
+  if(argc < 7){                       //Print help if wrong number of cli arguments
     printf("usage: %s \n",argv[0]);
     print_usage();
     return 0;
@@ -107,86 +179,92 @@ int main(int argc, char *argv[]){
     exit(0);
   }
 
-  int size = atoi(argv[2]) * 1024;   //Get cache size from argument
-  int linesize = atoi(argv[3]);      //Get line size from argument
-  int assoc = atoi(argv[4]);         //Get associativity from argument
+  //Get cache configuration and optional settings from cli arguments
+  CacheConfig config;
+  Options opts;
+  if(parse_config(argc,argv,2,config,opts) == -1)
+    return 0;
 
-  if(size % linesize !=0){
-    std::cout << "-----------------------------------\n";
-    std::cout << "ERROR: size must be a multiple of line size\n";
-    std::cout << "-----------------------------------\n";
-    print_usage();
-    return 0;  
+  //Prints cache configuration information to stdout
+  print_config(config.num_lines * config.line_size,config.line_size,config.associativity,
+               config.num_lines / config.associativity);
+  std::cout << "Seed: "<< opts.seed << std::endl;
+
+  //Optional output for the miss stream
+  std::ofstream miss_out;
+  if(!opts.miss_file.empty()){
+    miss_out.open(opts.miss_file.c_str());
+    if(!miss_out.is_open()){
+      std::cout << "unable to open file "<< opts.miss_file <<std::endl;
+      exit(0);
+    }
   }
 
-  int num_lines = size / linesize;    //Calculate total number of cache lines
-  if(num_lines < assoc ){
-    std::cout << "-----------------------------------\n";
-    std::cout << "ERROR: associativity cannot be greater than the number of lines\n";
-    std::cout << "-----------------------------------\n";
-
-    print_usage();
-    return 0;  
+  //Optional output for the working set series
+  std::ofstream ws_out;
+  if(!opts.ws_file.empty()){
+    ws_out.open(opts.ws_file.c_str());
+    if(!ws_out.is_open()){
+      std::cout << "unable to open file "<< opts.ws_file <<std::endl;
+      exit(0);
+    }
   }
-  
- if(num_lines % assoc != 0){
-    std::cout << "-----------------------------------\n";
-    std::cout << "ERROR: number of lines must be a multiple of accociativity\n";
-    std::cout << "-----------------------------------\n";
 
-    print_usage();
-    return 0;  
-  }
+  //Input still being written, executions simulated serially as they complete
+  if(opts.follow){
+    Simulator sim(config,opts);
+    exec_follow(input,sim,opts,miss_out,ws_out);
 
-  //Get replacement policy from cli argument
-  int replacement = parse_replacement_policy(argv[5]);
-  if(replacement==-1)
+    //Prints cache performance data to stdout
+    sim.report().print(std::cout,opts);
     return 0;
-
-  //Get write policy from cli argument
-  int write_pol = parse_write_policy(argv[6]);
-  if(write_pol == -1)  
-     return 0;
-
-
-
-  //Prints cache configuration information to stdout
-  print_config(size,linesize,assoc, num_lines / assoc); 
-
-  Cache cache(num_lines,linesize, assoc, replacement,write_pol);
-
-  
+  }
 
   /*
   *  parses trace vector into a vector of traces from individual kernel executions
   */
 
-  TRACE_VEC executions = parse(input);
+  TRACE_VEC executions = parse(input,opts.filter);
 
+  if(opts.replicas > 1){
+    //Runs sample replicas of the trace concurrently
+    std::string misses, series;
+    std::vector<Report> results = exec_replicas(executions,config,opts,misses,series);
+    miss_out << misses;
+    ws_out << series;
 
-  //Runs the trace through the simulator
-  exec_trace(executions, cache);
+    //Prints the spread of cache performance over the replicas
+    print_replicas(std::cout,results,opts);
+  }
+  else if(opts.threads > 0){
+    //Runs executions through the simulator concurrently
+    std::vector<std::string> misses, series;
+    std::vector<Report> results = exec_parallel(executions,config,opts,misses,series);
+
+    Report total(opts);
+    for(unsigned int i=0;i<results.size();i++){
+      std::cout <<"\nTrace " << i << " of "<<results.size()<<": "<< results[i].stats.getNumAccess()
+                <<" accesses, miss rate "<< results[i].stats.getTotalMissRate() <<std::endl;
+      if(results[i].tlb.enabled())
+        results[i].tlb.print_execution(std::cout);
+      total += results[i];
+      miss_out << misses[i];
+      ws_out << series[i];
+    }
+
+    //Prints cache performance data to stdout
+    total.print(std::cout,opts);
+  }
+  else{
+    Simulator sim(config,opts);
+
+    //Runs the trace through the simulator
+    exec_trace(executions, sim, miss_out, ws_out);
 
-  //Prints cache performance data to stdout
-  std::cout<<cache.stats;
+    //Prints cache performance data to stdout
+    sim.report().print(std::cout,opts);
+  }
 
  
 }
 
-
-
-/*
-  Calculates the ceiling of a over b
-*/
-unsigned int ceiling(unsigned int a, unsigned int b){
-  
-   if(!a || !b)
-       return 0;
-
-   if(a% b ==0){
-     return a/ b;
-   }
-   else{
-     return (a/b) +1;
-   }
-}
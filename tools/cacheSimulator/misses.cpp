@@ -0,0 +1,61 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include "misses.h"
+
+
+MissStream::MissStream():recording(false),timestamp(0){}
+
+void MissStream::begin(unsigned int warp_size, unsigned int total_wk){
+  if(!recording)
+    return;
+
+  out << warp_size << " " << total_wk << std::endl;
+}
+
+void MissStream::request(unsigned long address, bool read, unsigned int bytes){
+  if(!recording)
+    return;
+
+  out << std::hex << address << std::dec << " "
+      << read << " "
+      << curr.wk_id << " "
+      << curr.warp_id << " "
+      << curr.inst << " "
+      << timestamp << " "
+      << bytes << std::endl;
+}
+
+std::string MissStream::take(){
+  if(!recording)
+    return std::string();
+
+  out << "------------------------" << std::endl;
+
+  std::string records = out.str();
+  clear();
+  return records;
+}
+
+void MissStream::clear(){
+  out.str("");
+  out.clear();
+}
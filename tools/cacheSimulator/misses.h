@@ -0,0 +1,61 @@
+/*
+ * misses.h
+ *
+ * Records the traffic leaving a cache in the trace format cacheSim reads,
+ * so the miss stream of one run can be replayed by another.
+ */
+#ifndef MISSES_H
+#define MISSES_H
+
+#include <sstream>
+#include <string>
+
+#include "common.h"
+#include "store.h"
+
+
+class MissStream : public MemoryLevel
+{
+  public:
+    MissStream();
+
+    /*
+     * Starts recording. Until then every call returns at once, so runs
+     * writing no miss stream pay nothing for it.
+    */
+    void open(){ recording = true;}
+
+    // Starts the records of an execution with its trace header
+    void begin(unsigned int warp_size, unsigned int total_wk);
+
+    // Access currently being simulated, and its position in the execution
+    void set_access(const Entry& e, unsigned long index){
+      if(recording){
+        curr = e;
+        timestamp = index;
+      }
+    }
+
+    /*
+     * Writes a record for a fill, write back or write through, attributed
+     * to the access which caused it. The access index is appended as a
+     * timestamp after the usual fields, then the bytes requested, so a
+     * word written through can be told from a whole line filled.
+     */
+    void request(unsigned long address, bool read, unsigned int bytes);
+
+    // Ends the execution and returns its records, clearing the stream
+    std::string take();
+
+    // Drops any records written so far
+    void clear();
+
+  private:
+    std::ostringstream out;
+    bool recording;            //Whether the stream is open
+
+    Entry curr;                //Access which caused the traffic
+    unsigned long timestamp;   //Index of that access in the execution
+};
+
+#endif
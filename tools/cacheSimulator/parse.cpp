@@ -19,52 +19,63 @@ You should have received a copy of the GNU General Public License
 along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
 */
 
+#include <ctype.h>
+
 #include "parse.h"
 #include "cache.h"
 
 
 
-TRACE_VEC parse(std::ifstream& input){
-  TRACE_VEC exections;
-
+/*
+ *  Reads the next kernel execution, a header line 'warp size total workgroups'
+ *  followed by its memory trace, up to the line of hyphens ending it
+*/
+std::unique_ptr<Execution> parse_execution(LineFollower& input, const AccessFilter& filter){
 
   unsigned int warp_size;
   unsigned int total_wk;
   std::string line;
 
-  getline(input,line);
-  sscanf (line.c_str(),"%u %u",&warp_size,&total_wk);
-  std::vector<unsigned int> workgroups = get_workgroups(warp_size,total_wk);
-  
-  
+  if(!input.getline(line) || sscanf (line.c_str(),"%u %u",&warp_size,&total_wk) != 2)
+    return NULL;
+  std::unique_ptr<Execution> trace(new Execution(warp_size,total_wk));
+
+
   /*
-  *  Reads memory trace from file 
-  */  
+  *  Reads memory trace from file
+  */
 
   unsigned int  wk_id,warp_id,inst,op;
-  unsigned long address; 
-  std::list<Entry> trace;
-  while(getline(input,line)){
-  
-    if((line.find("-") < line.length()) && !input.eof()){
-         exections.push_back(std::make_tuple(workgroups,warp_size,trace));
-         
-         getline(input,line);
-         if(!input.eof()){
+  unsigned long address;
+  while(input.getline(line)){
 
-         
-           sscanf (line.c_str(),"%u %u",&warp_size,&total_wk);
-           workgroups = get_workgroups(warp_size,total_wk);
-        } 
-         
-    }else{
+    if(line.find("-") < line.length())
+      return trace;
 
-      sscanf (line.c_str(),"%lX %d %d %d %d\n",&address,&op,&wk_id,&warp_id,&inst);
-      Entry e(address,op,wk_id,warp_id,inst);
+    //Fields after the first five, such as the timestamp and bytes of a
+    //miss stream record, are skipped
+    sscanf (line.c_str(),"%lX %d %d %d %d",&address,&op,&wk_id,&warp_id,&inst);
 
-      trace.push_back(e);
-    }
+    //Accesses outside the slice of interest are never stored
+    if(filter.enabled() && !(filter.matches(FILTER_INST,inst) && filter.matches(FILTER_ADDR,address) &&
+                             filter.matches(FILTER_WK,wk_id) && filter.matches(FILTER_OP,op & OP_READ)))
+      continue;
+
+    Entry e(address,op,wk_id,warp_id,inst);
 
+    trace->push(e);
+  }
+
+  //Execution cut short, its end never written
+  return NULL;
+}
+
+TRACE_VEC parse(std::ifstream& input, const AccessFilter& filter){
+  TRACE_VEC exections;
+
+  LineFollower lines(input);
+  while(std::unique_ptr<Execution> trace = parse_execution(lines,filter)){
+    exections.push_back(std::move(trace));
   }
 
   return exections;
@@ -73,6 +84,434 @@ TRACE_VEC parse(std::ifstream& input){
 
 
 
+/*
+ *  Parses cache configuration and optional settings from cli arguments
+*/
+int parse_config(int argc, char* argv[], int first, CacheConfig& config, Options& opts){
+
+  if(argc < first + 5){
+    print_usage();
+    return -1;
+  }
+
+  int size = atoi(argv[first]) * 1024;     //Get cache size from argument
+  int linesize = atoi(argv[first + 1]);    //Get line size from argument
+  int assoc = atoi(argv[first + 2]);       //Get associativity from argument
+
+  if(size <= 0 || linesize <= 0 || assoc <= 0 || size % linesize !=0){
+    std::cout << "-----------------------------------\n";
+    std::cout << "ERROR: size must be a multiple of line size\n";
+    std::cout << "-----------------------------------\n";
+    print_usage();
+    return -1;
+  }
+
+  int num_lines = size / linesize;    //Calculate total number of cache lines
+  if(num_lines < assoc ){
+    std::cout << "-----------------------------------\n";
+    std::cout << "ERROR: associativity cannot be greater than the number of lines\n";
+    std::cout << "-----------------------------------\n";
+
+    print_usage();
+    return -1;
+  }
+
+  if(num_lines % assoc != 0){
+    std::cout << "-----------------------------------\n";
+    std::cout << "ERROR: number of lines must be a multiple of accociativity\n";
+    std::cout << "-----------------------------------\n";
+
+    print_usage();
+    return -1;
+  }
+
+  //Get replacement policy from cli argument
+  int replacement = parse_replacement_policy(argv[first + 3]);
+  if(replacement==-1)
+    return -1;
+
+  //Get write policy from cli argument
+  int write_pol = parse_write_policy(argv[first + 4]);
+  if(write_pol == -1)
+     return -1;
+
+  //Get optional settings from remaining cli arguments
+  if(parse_options(argc,argv,first + 5,opts) == -1)
+     return -1;
+
+  if(opts.all && opts.occupancy.resident){
+    std::cout << "-----------------------------------\n";
+    std::cout << "ERROR: -occupancy interleaves the sampled workgroups, it cannot be used with -all\n";
+    std::cout << "-----------------------------------\n";
+    return -1;
+  }
+
+  config.num_lines = num_lines;
+  config.line_size = linesize;
+  config.associativity = assoc;
+  config.rep_policy = replacement;
+  config.write_policy = write_pol;
+  config.index = opts.index;
+
+  //Hashes given bit by bit must name every bit of the set index
+  unsigned int index_bits = 0;
+  while((1u << index_bits) < (unsigned int)(num_lines / assoc))
+    index_bits++;
+
+  if((opts.index.type == CACHE_INDEX_PERMUTE && opts.index.bits.size() != index_bits) ||
+     (opts.index.type == CACHE_INDEX_MATRIX && opts.index.rows.size() != index_bits)){
+    std::cout << "-----------------------------------\n";
+    std::cout << "ERROR: set index function needs one entry for each of the "<< index_bits <<" index bits\n";
+    std::cout << "-----------------------------------\n";
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ *  Parses DRAM configuration 'channels:banks:row bytes:interleave bytes:page policy'
+*/
+int parse_dram(char* arg, DramConfig& config){
+  if(strcmp("default",arg)==0){
+    config = DRAM_DEFAULT;
+    return 0;
+  }
+
+  char policy[16];
+  int n = sscanf(arg,"%u:%u:%u:%u:%15s",&config.channels,&config.banks,
+                 &config.row_size,&config.interleave,policy);
+
+  if(n == 5 && strcmp("open",policy)==0)
+    config.page_policy = DRAM_PAGE_OPEN;
+  else if(n == 5 && strcmp("closed",policy)==0)
+    config.page_policy = DRAM_PAGE_CLOSED;
+  else
+    n = 0;
+
+  if(n == 0 || !config.channels || !config.banks || !config.row_size || !config.interleave){
+    std::cout << "-----------------------------------\n";
+    std::cout << "Invalid DRAM configuration "<< arg <<"\n";
+    std::cout << "-----------------------------------\n";
+    print_usage();
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ *  Splits a comma separated list
+*/
+static void split_list(const char* arg, std::vector<std::string>& items){
+  std::string list(arg);
+  size_t start = 0;
+  while(start <= list.size()){
+    size_t end = list.find(',',start);
+    if(end == std::string::npos)
+      end = list.size();
+    if(end > start)
+      items.push_back(list.substr(start,end - start));
+    start = end + 1;
+  }
+}
+
+/*
+ *  Parses set index function 'mod', 'xor', 'prime', 'perm:bit,bit,...'
+ *  or 'matrix:file', where the file holds one hex mask over the block
+ *  address for each index bit, lowest bit first.
+*/
+int parse_index(char* arg, IndexFunction& function){
+  bool valid = true;
+
+  if(strcmp("mod",arg)==0)
+    function.type = CACHE_INDEX_MODULO;
+  else if(strcmp("xor",arg)==0)
+    function.type = CACHE_INDEX_XOR;
+  else if(strcmp("prime",arg)==0)
+    function.type = CACHE_INDEX_PRIME;
+  else if(strncmp("perm:",arg,5)==0){
+    function.type = CACHE_INDEX_PERMUTE;
+
+    std::vector<std::string> bits;
+    split_list(arg + 5,bits);
+    for(unsigned int i=0;i<bits.size();i++){
+      unsigned int position = atoi(bits[i].c_str());
+      valid = valid && position < 64;
+      function.bits.push_back(position);
+    }
+  }
+  else if(strncmp("matrix:",arg,7)==0){
+    function.type = CACHE_INDEX_MATRIX;
+
+    std::ifstream file(arg + 7);
+    if(!file.is_open()){
+      std::cout << "unable to open file "<< arg + 7 <<std::endl;
+      return -1;
+    }
+
+    std::string line;
+    while(std::getline(file,line)){
+      unsigned long row;
+      if(sscanf(line.c_str(),"%lx",&row) == 1)
+        function.rows.push_back(row);
+    }
+  }
+  else
+    valid = false;
+
+  if(!valid){
+    std::cout << "-----------------------------------\n";
+    std::cout << "Invalid set index function "<< arg <<"\n";
+    std::cout << "-----------------------------------\n";
+    print_usage();
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ *  Parses TLB level 'entries:associativity:page bytes[:shared]'
+*/
+int parse_tlb(char* arg, TlbConfig& config){
+  char sharing[16] = "";
+  int n = sscanf(arg,"%u:%u:%u:%15s",&config.entries,&config.associativity,
+                 &config.page_size,sharing);
+
+  config.shared = (strcmp("shared",sharing)==0);
+  if(n == 4 && !config.shared)
+    n = 0;
+
+  if(n < 3 || !config.entries || !config.associativity || !config.page_size
+     || config.entries % config.associativity != 0){
+    std::cout << "-----------------------------------\n";
+    std::cout << "Invalid TLB configuration "<< arg <<"\n";
+    std::cout << "-----------------------------------\n";
+    print_usage();
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ *  Parses read-only cache 'size in KB:line size:associativity[:replacement]'
+*/
+int parse_ro_cache(char* arg, CacheConfig& config){
+  unsigned int size;
+  char policy[16] = "LRU";
+  int n = sscanf(arg,"%u:%u:%u:%15s",&size,&config.line_size,&config.associativity,policy);
+
+  size *= 1024;
+  bool valid = (n >= 3 && size && config.line_size && config.associativity && size % config.line_size == 0);
+  if(valid){
+    config.num_lines = size / config.line_size;
+    valid = config.num_lines >= config.associativity && config.num_lines % config.associativity == 0;
+  }
+
+  if(!valid){
+    std::cout << "-----------------------------------\n";
+    std::cout << "Invalid read-only cache "<< arg <<"\n";
+    std::cout << "-----------------------------------\n";
+    print_usage();
+    return -1;
+  }
+
+  int replacement = parse_replacement_policy(policy);
+  if(replacement == -1)
+    return -1;
+
+  config.rep_policy = replacement;
+  config.write_policy = CACHE_WRITEPOLICY_WTNA;      //Never written
+  return 0;
+}
+
+/*
+ *  Parses local memory banks 'banks:word bytes'
+*/
+int parse_banks(char* arg, BankConfig& config){
+  int n = sscanf(arg,"%u:%u",&config.banks,&config.width);
+
+  if(n != 2 || !config.banks || !config.width){
+    std::cout << "-----------------------------------\n";
+    std::cout << "Invalid local memory banks "<< arg <<"\n";
+    std::cout << "-----------------------------------\n";
+    print_usage();
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ *  Parses occupancy 'resident workgroups[:lrr|gto[:miss latency]]'
+*/
+int parse_occupancy(char* arg, OccupancyConfig& config){
+  char policy[16] = "lrr";
+  int n = sscanf(arg,"%u:%15[^:]:%u",&config.resident,policy,&config.latency);
+
+  if(strcmp("lrr",policy)==0)
+    config.policy = WARP_POLICY_LRR;
+  else if(strcmp("gto",policy)==0)
+    config.policy = WARP_POLICY_GTO;
+  else
+    n = 0;
+
+  if(n < 1 || config.resident == 0){
+    std::cout << "-----------------------------------\n";
+    std::cout << "Invalid occupancy "<< arg <<"\n";
+    std::cout << "-----------------------------------\n";
+    print_usage();
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ *  Parses working set window 'window:stride[:warp|access]'
+*/
+int parse_working_set(char* arg, WorkingSetConfig& config){
+  char unit[16] = "access";
+  int n = sscanf(arg,"%u:%u:%15s",&config.window,&config.stride,unit);
+
+  if(strcmp("warp",unit)==0)
+    config.warp = true;
+  else if(strcmp("access",unit)==0)
+    config.warp = false;
+  else
+    n = 0;
+
+  if(n < 2 || !config.window || !config.stride){
+    std::cout << "-----------------------------------\n";
+    std::cout << "Invalid working set window "<< arg <<"\n";
+    std::cout << "-----------------------------------\n";
+    print_usage();
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ *  Parses optional settings from cli arguments
+*/
+int parse_options(int argc, char* argv[], int first, Options& opts){
+  for(int i=first;i<argc;i++){
+    if(strcmp("-p",argv[i])==0 && i+1 < argc){             //Parallel simulation
+      opts.threads = atoi(argv[++i]);
+    }
+    else if(strcmp("-warm",argv[i])==0 && i+1 < argc){     //Warm cache prefix
+      ++i;
+      opts.warm = strcmp("all",argv[i])==0 ? WARM_ALL : atoi(argv[i]);
+    }
+    else if(strcmp("-all",argv[i])==0){                     //No workgroup sampling
+      opts.all = true;
+    }
+    else if(strcmp("-o",argv[i])==0 && i+1 < argc){        //Miss stream output
+      opts.miss_file = argv[++i];
+    }
+    else if(strcmp("-dram",argv[i])==0 && i+1 < argc){     //DRAM model
+      opts.dram = true;
+      if(parse_dram(argv[++i],opts.dram_config) == -1)
+        return -1;
+    }
+    else if(strcmp("-index",argv[i])==0 && i+1 < argc){    //Set index function
+      if(parse_index(argv[++i],opts.index) == -1)
+        return -1;
+    }
+    else if(strcmp("-wk",argv[i])==0 && i+1 < argc){       //Workgroup subset
+      std::vector<std::string> workgroups;
+      split_list(argv[++i],workgroups);
+      for(unsigned int w=0;w<workgroups.size();w++){
+        opts.workgroups.push_back(atoi(workgroups[w].c_str()));
+      }
+    }
+    else if(strcmp("-rocache",argv[i])==0 && i+1 < argc){  //Read-only cache
+      opts.ro_cache = true;
+      if(parse_ro_cache(argv[++i],opts.ro_config) == -1)
+        return -1;
+    }
+    else if(strcmp("-ro",argv[i])==0 && i+1 < argc){       //Read-only routing
+      ++i;
+      opts.ro_insts.clear();
+      if(strcmp("auto",argv[i])==0)
+        opts.ro_route = RO_AUTO;
+      else if(strcmp("none",argv[i])==0)
+        opts.ro_route = RO_NONE;
+      else{
+        opts.ro_route = RO_LISTED;
+        std::vector<std::string> insts;
+        split_list(argv[i],insts);
+        for(unsigned int n=0;n<insts.size();n++){
+          opts.ro_insts.push_back(atoi(insts[n].c_str()));
+        }
+      }
+    }
+    else if(strcmp("-banks",argv[i])==0 && i+1 < argc){    //Local memory banks
+      if(parse_banks(argv[++i],opts.banks) == -1)
+        return -1;
+    }
+    else if(strcmp("-occupancy",argv[i])==0 && i+1 < argc){  //Resident workgroups
+      if(parse_occupancy(argv[++i],opts.occupancy) == -1)
+        return -1;
+    }
+    else if(strcmp("-seed",argv[i])==0 && i+1 < argc){     //Random seed
+      opts.seed = strtoull(argv[++i],NULL,10);
+    }
+    else if(strcmp("-replicas",argv[i])==0 && i+1 < argc){ //Sample replicas
+      opts.replicas = atoi(argv[++i]);
+      if(opts.replicas == 0)
+        opts.replicas = 1;
+    }
+    else if(strcmp("-stats",argv[i])==0 && i+1 < argc){    //Statistics printed
+      split_list(argv[++i],opts.stats);
+    }
+    else if(strcmp("-follow",argv[i])==0){                  //Follow a growing input
+      opts.follow = true;
+      if(i+1 < argc && isdigit(argv[i+1][0]))
+        opts.follow_idle = atoi(argv[++i]);
+    }
+    else if(strcmp("-filter",argv[i])==0 && i+1 < argc){   //Slice of the trace
+      ++i;
+      if(!opts.filter.parse(argv[i]) || opts.filter.uses(FILTER_LOOP)){
+        std::cout << "-----------------------------------\n";
+        std::cout << "Invalid filter "<< argv[i] <<"\n";
+        if(opts.filter.uses(FILTER_LOOP))
+          std::cout << "Loop clauses need loop data, filter with the scheduler instead\n";
+        std::cout << "-----------------------------------\n";
+        print_usage();
+        return -1;
+      }
+    }
+    else if(strcmp("-buffers",argv[i])==0 && i+1 < argc){  //Buffer address ranges
+      opts.buffers.reset(new BufferTable());
+      if(!opts.buffers->load(argv[++i])){
+        std::cout << "unable to open file "<< argv[i] <<std::endl;
+        return -1;
+      }
+    }
+    else if(strcmp("-reuse",argv[i])==0){                   //Reuse profile
+      opts.reuse = true;
+      if(i+1 < argc && isdigit(argv[i+1][0]))
+        opts.scratchpad = atoi(argv[++i]);
+    }
+    else if(strcmp("-ws",argv[i])==0 && i+2 < argc){       //Working set series
+      opts.ws_file = argv[++i];
+      if(parse_working_set(argv[++i],opts.working_set) == -1)
+        return -1;
+    }
+    else if(strcmp("-tlb",argv[i])==0 && i+1 < argc){      //TLB level
+      TlbConfig level;
+      if(parse_tlb(argv[++i],level) == -1)
+        return -1;
+      opts.tlb.push_back(level);
+    }
+    else{                                                   //Invalid option
+      std::cout << "-----------------------------------\n";
+      std::cout << "Unrecognised option "<< argv[i] <<"\n";
+      std::cout << "-----------------------------------\n";
+      print_usage();
+      return -1;
+    }
+  }
+  return 0;
+}
+
 /*
  *  Parses to cache write policy from cli argument
 */
@@ -81,6 +520,10 @@ int parse_write_policy(char* arg){
     return CACHE_WRITEPOLICY_WBWA;
   else if(strcmp("WTNA",arg)==0)    //Write Through No-Allocate
     return CACHE_WRITEPOLICY_WTNA;
+  else if(strcmp("WE",arg)==0)      //Write Evict
+    return CACHE_WRITEPOLICY_WE;
+  else if(strcmp("WTWA",arg)==0)    //Write Through Write Allocate
+    return CACHE_WRITEPOLICY_WTWA;
   else{                             //Invalid Policy
     std::cout << "-----------------------------------\n";
     std::cout << "No valid write policy selected\n";
@@ -123,7 +566,43 @@ void print_usage(){
     std::cout << "line size in Bytes\n";
     std::cout << "associativity\n";
     std::cout << "replacement policy: 'LRU','LFU,'MRU', 'RAND'\n";
-    std::cout << "writepolicy: 'WBWA','WTNA'\n";
+    std::cout << "writepolicy: 'WBWA','WTNA','WE','WTWA'\n";
+    std::cout << "options:\n";
+    std::cout << "  -p threads     simulate executions in parallel, each on its own cache\n";
+    std::cout << "  -warm n|all    with -p, warm each cache with the n preceding executions\n";
+    std::cout << "  -all           replay every access in trace order, without sampling workgroups\n";
+    std::cout << "  -o file        write the cache's miss and write back stream to file\n";
+    std::cout << "  -dram channels:banks:row bytes:interleave bytes:open|closed\n";
+    std::cout << "                 model DRAM behind the cache, or '-dram default'\n";
+    std::cout << "  -index mod|xor|prime|perm:bit,...|matrix:file\n";
+    std::cout << "                 set index function, modulo by default\n";
+    std::cout << "  -wk w,...      simulate these workgroups instead of a random sample\n";
+    std::cout << "  -rocache size in KB:line size:assoc[:replacement]\n";
+    std::cout << "                 send read-only loads through a cache of their own\n";
+    std::cout << "  -ro auto|none|inst,...\n";
+    std::cout << "                 read-only loads: as marked in the trace, none, or these instructions\n";
+    std::cout << "  -banks n:bytes local memory banks and bytes per bank word, 32:4 by default\n";
+    std::cout << "  -occupancy n[:lrr|gto[:latency]]\n";
+    std::cout << "                 keep n sampled workgroups resident, interleaving their warps\n";
+    std::cout << "  -seed n        seed workgroup sampling and random replacement, the clock by default\n";
+    std::cout << "  -replicas k    simulate k independent samples, reporting mean, variance\n";
+    std::cout << "                 and 95% confidence interval of each statistic\n";
+    std::cout << "  -stats name,...\n";
+    std::cout << "                 print only the named statistics, e.g. miss_rate,write_backs\n";
+    std::cout << "  -tlb entries:assoc:page bytes[:shared]\n";
+    std::cout << "                 add a TLB level, per core unless shared, repeat for more levels\n";
+    std::cout << "  -filter clause,...\n";
+    std::cout << "                 keep only accesses matching inst=n[-m], addr=lo-hi (hex),\n";
+    std::cout << "                 wk=n[-m] and op=r|w, repeated clauses being alternatives\n";
+    std::cout << "  -buffers file  report accesses, misses and footprint of each buffer\n";
+    std::cout << "                 named in the wrapper's buffers.txt\n";
+    std::cout << "  -reuse [KB]    profile reuse distances per instruction, ranking them by the\n";
+    std::cout << "                 misses a workgroup scratchpad of KB, 48 by default, would remove\n";
+    std::cout << "  -ws file window:stride[:warp|access]\n";
+    std::cout << "                 write to file the distinct lines each core touched over a sliding\n";
+    std::cout << "                 window of accesses or warp instructions, every stride of them\n";
+    std::cout << "  -follow [secs] simulate each execution as soon as it is appended to the file,\n";
+    std::cout << "                 ending once it stops growing for secs, 10 by default\n";
 }
 
 
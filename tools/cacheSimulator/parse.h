@@ -4,17 +4,103 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 #include <fstream>
 #include <vector>
-#include <list>
-#include <tuple>
+#include <string>
+#include <memory>
 
 #include "common.h"
+#include "cache.h"
+#include "store.h"
+#include "dram.h"
+#include "tlb.h"
+#include "banks.h"
+#include "interleave.h"
+#include "reuse.h"
+#include "workingset.h"
+#include "follow.h"
+#include "filter.h"
+#include "buffer_table.h"
 
-typedef std::vector<std::tuple<std::vector<unsigned int>,unsigned int,std::list<Entry>>>  TRACE_VEC;
+typedef std::vector<std::unique_ptr<Execution> >  TRACE_VEC;
 
+const int WARM_ALL = -1;   //Warm each cache with every preceding execution
 
-TRACE_VEC parse(std::ifstream& input);
+/*
+ *  Which loads go through the read-only cache
+*/
+const int RO_AUTO   = 0;   //Loads the trace marks as read-only
+const int RO_NONE   = 1;   //None, read-only cache unused
+const int RO_LISTED = 2;   //Loads of the instructions listed by the user
+
+/*
+ *  Optional settings given after the cache configuration
+*/
+class Options{
+ public:
+  Options():threads(0),warm(0),all(false),dram(false),dram_config(DRAM_DEFAULT),
+           ro_cache(false),ro_route(RO_AUTO),banks(BANKS_DEFAULT),seed(time(NULL)),replicas(1),
+           follow(false),follow_idle(FOLLOW_IDLE_DEFAULT),reuse(false),scratchpad(SCRATCHPAD_DEFAULT){
+    working_set.window = 0;
+    working_set.stride = 1;
+    working_set.warp = false;
+    occupancy.resident = 0;
+    occupancy.policy = WARP_POLICY_LRR;
+    occupancy.latency = MISS_LATENCY;
+  }
+
+  unsigned int threads;   //Threads simulating executions in parallel, 0 for serial
+  int warm;               //Preceding executions replayed to warm each parallel cache
+  bool all;               //Replay every access in trace order, without sampling workgroups
+
+  std::string miss_file;  //File the miss stream is written to, empty for none
+
+  bool dram;              //Feed the cache's memory traffic to a DRAM model
+  DramConfig dram_config;
+
+  IndexFunction index;    //Set index function of the cache
+
+  bool ro_cache;            //Route read-only loads to a cache of their own
+  CacheConfig ro_config;
+  int ro_route;             //RO_AUTO, RO_NONE or RO_LISTED
+  std::vector<unsigned int> ro_insts;   //Instructions routed with RO_LISTED
+
+  std::vector<TlbConfig> tlb;   //TLB levels, first level first, empty for none
+
+  BankConfig banks;       //Local memory banks
+
+  std::vector<unsigned int> workgroups;   //Workgroups simulated, empty to sample them
+  std::vector<std::string> stats;         //Statistics printed, empty for the whole report
+
+  unsigned long long seed;  //Seeds workgroup sampling and random replacement
+  unsigned int replicas;    //Independently sampled runs of the whole trace
+
+  OccupancyConfig occupancy;  //Workgroups resident on the core and how their warps interleave
+
+  bool follow;              //Simulate executions as they are appended to the input
+  unsigned int follow_idle; //Seconds the input may stop growing before the run ends
+
+  AccessFilter filter;      //Accesses kept while parsing, every one if not enabled
+
+  std::shared_ptr<BufferTable> buffers;   //Buffer address ranges accesses are attributed to
+
+  bool reuse;               //Profile the reuse distances of each instruction
+  unsigned int scratchpad;  //KB of local memory a workgroup could stage data in
+
+  std::string ws_file;         //File the working set series is written to, empty for none
+  WorkingSetConfig working_set;
+};
+
+
+TRACE_VEC parse(std::ifstream& input, const AccessFilter& filter = AccessFilter());
+
+/*
+ *  Parses the next kernel execution once its terminating line has been read,
+ *  keeping only the accesses passing the filter. Returns NULL at the end of
+ *  the input.
+*/
+std::unique_ptr<Execution> parse_execution(LineFollower& input, const AccessFilter& filter = AccessFilter());
 
 
 /*
@@ -25,6 +111,53 @@ void print_usage();
 void print_config(int size, int line_size, int assoc, int num_sets);
 
 
+/*
+ *  Parses the cache configuration 'size line size associativity replacement
+ *  write policy' starting at argv[first], followed by optional settings.
+ *  Returns -1 if the configuration is invalid.
+*/
+int parse_config(int argc, char* argv[], int first, CacheConfig& config, Options& opts);
+
+/*
+ *  Parses DRAM configuration from cli argument
+*/
+int parse_dram(char* arg, DramConfig& config);
+
+/*
+ *  Parses set index function from cli argument
+*/
+int parse_index(char* arg, IndexFunction& function);
+
+/*
+ *  Parses configuration of a TLB level from cli argument
+*/
+int parse_tlb(char* arg, TlbConfig& config);
+
+/*
+ *  Parses read-only cache configuration from cli argument
+*/
+int parse_ro_cache(char* arg, CacheConfig& config);
+
+/*
+ *  Parses local memory banks from cli argument
+*/
+int parse_banks(char* arg, BankConfig& config);
+
+/*
+ *  Parses occupancy setting from cli argument
+*/
+int parse_occupancy(char* arg, OccupancyConfig& config);
+
+/*
+ *  Parses working set window from cli argument
+*/
+int parse_working_set(char* arg, WorkingSetConfig& config);
+
+/*
+ *  Parses optional settings from cli arguments, starting at argv[first]
+*/
+int parse_options(int argc, char* argv[], int first, Options& opts);
+
 /*
  *  Parses to cache write policy from cli argument
 */
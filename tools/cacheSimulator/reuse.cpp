@@ -0,0 +1,239 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+#include <iomanip>
+
+#include "reuse.h"
+
+
+void Fenwick::push(int value){
+  unsigned int time = tree.size() + 1;
+  unsigned int low = time & (~time + 1);
+
+  //A node holds the sum of the 'low' times ending at it
+  tree.push_back(value + prefix(time - 1) - prefix(time - low));
+}
+
+void Fenwick::add(unsigned int time, int delta){
+  for(;time <= tree.size();time += time & (~time + 1)){
+    tree[time - 1] += delta;
+  }
+}
+
+int Fenwick::prefix(unsigned int time) const{
+  int sum = 0;
+  for(;time > 0;time -= time & (~time + 1)){
+    sum += tree[time - 1];
+  }
+  return sum;
+}
+
+
+long ReuseWindow::touch(unsigned long line){
+  unsigned int now = marks.size() + 1;
+  long distance = -1;
+
+  std::unordered_map<unsigned long,unsigned int>::iterator previous = last.find(line);
+  if(previous != last.end()){
+    //Lines whose last use falls after this line's
+    distance = marks.prefix(now - 1) - marks.prefix(previous->second);
+    marks.add(previous->second,-1);
+    previous->second = now;
+  }
+  else
+    last[line] = now;
+
+  marks.push(1);
+  return distance;
+}
+
+
+InstReuse& InstReuse::operator+= (const InstReuse& right){
+  uses += right.uses;
+  cold += right.cold;
+  misses += right.misses;
+  removable += right.removable;
+  for(int c=0;c<REUSE_CLASSES;c++)
+    for(unsigned int b=0;b<REUSE_BUCKETS;b++)
+      histogram[c][b] += right.histogram[c][b];
+  return *this;
+}
+
+
+ReuseProfile::ReuseProfile(unsigned int line, unsigned int lines, unsigned int scratchpad):
+    line_size(line),cache_lines(lines),scratchpad_lines(line ? scratchpad / line : 0),
+    warp_size(0),in_group(false){}
+
+void ReuseProfile::begin_execution(unsigned int warp){
+  all.marks.clear();
+  all.last.clear();
+  by_wk.clear();
+  warp_size = warp;
+  in_group = false;
+}
+
+/*
+ * Lines a warp instruction touches several times are coalesced, so only
+ * count once. An instruction's group ends when another begins or after
+ * a warp's worth of accesses.
+*/
+void ReuseProfile::access(const Entry& e){
+  unsigned long line = e.address / line_size;
+
+  if(!in_group || e.wk_id != group_wk || e.warp_id != group_warp || e.inst != group_inst ||
+     group_size == warp_size){
+    in_group = true;
+    group_wk = e.wk_id;
+    group_warp = e.warp_id;
+    group_inst = e.inst;
+    group_size = 0;
+    group_lines.clear();
+  }
+  group_size++;
+
+  if(std::find(group_lines.begin(),group_lines.end(),line) != group_lines.end())
+    return;
+  group_lines.push_back(line);
+
+  use(line,e);
+}
+
+/*
+ * A reuse is predicted to miss when more distinct lines than the cache
+ * holds came between the two uses. Reuse within a workgroup which misses
+ * could be served by the workgroup's scratchpad, if the lines the
+ * workgroup itself used in between fit there.
+*/
+void ReuseProfile::use(unsigned long line, const Entry& e){
+  InstReuse& reuse = by_inst[e.inst];
+  reuse.uses++;
+
+  long distance = all.touch(line);
+
+  ReuseWindow& workgroup = by_wk[e.wk_id];
+  long wk_distance = workgroup.touch(line);
+  unsigned int& last_warp = workgroup.warps[line];
+  bool same_warp = wk_distance >= 0 && last_warp == e.warp_id;
+  last_warp = e.warp_id;
+
+  if(distance < 0){
+    reuse.cold++;
+    reuse.misses++;
+    return;
+  }
+
+  int kind = REUSE_INTER;
+  if(wk_distance >= 0)
+    kind = same_warp ? REUSE_WARP : REUSE_WORKGROUP;
+
+  unsigned int bucket = 0;
+  while(bucket + 1 < REUSE_BUCKETS && (1ul << bucket) <= (unsigned long)distance)
+    bucket++;
+  reuse.histogram[kind][bucket]++;
+
+  if((unsigned long)distance >= cache_lines){
+    reuse.misses++;
+    if(kind != REUSE_INTER && wk_distance >= 0 && (unsigned long)wk_distance < scratchpad_lines)
+      reuse.removable++;
+  }
+}
+
+void ReuseProfile::clear_counts(){
+  by_inst.clear();
+}
+
+ReuseProfile& ReuseProfile::operator+= (const ReuseProfile& right){
+  if(!enabled()){
+    line_size = right.line_size;
+    cache_lines = right.cache_lines;
+    scratchpad_lines = right.scratchpad_lines;
+  }
+
+  for(std::map<unsigned int,InstReuse>::const_iterator iter = right.by_inst.begin(),
+      end = right.by_inst.end(); iter != end; ++iter){
+    by_inst[iter->first] += iter->second;
+  }
+  return *this;
+}
+
+void ReuseProfile::getValues(std::vector<NamedStat>& values) const{
+  if(!enabled())
+    return;
+
+  InstReuse total;
+  for(std::map<unsigned int,InstReuse>::const_iterator iter = by_inst.begin(),
+      end = by_inst.end(); iter != end; ++iter){
+    total += iter->second;
+  }
+  values.push_back(NamedStat("reuse_misses",total.misses));
+  values.push_back(NamedStat("reuse_removable",total.removable));
+}
+
+static bool more_removable(const std::pair<unsigned int,InstReuse>& a, const std::pair<unsigned int,InstReuse>& b){
+  if(a.second.removable != b.second.removable)
+    return a.second.removable > b.second.removable;
+  return a.second.misses > b.second.misses;
+}
+
+std::ostream & operator<< (std::ostream & os, const ReuseProfile& right){
+  os<<"\n==================================\n";
+  os<<"REUSE\n";
+  os<<"==================================\n";
+  os<<"Cache: "<< right.cache_lines <<" lines, scratchpad: "<< right.scratchpad_lines <<" lines of "
+    << right.line_size <<" bytes"<< std::endl;
+
+  //Instructions by the misses a scratchpad would remove
+  std::vector<std::pair<unsigned int,InstReuse> > ranked(right.by_inst.begin(),right.by_inst.end());
+  std::stable_sort(ranked.begin(),ranked.end(),more_removable);
+
+  os<< std::setw(6) <<"Inst"<< std::setw(12) <<"Uses"<< std::setw(12) <<"Cold"
+    << std::setw(12) <<"Misses"<< std::setw(12) <<"Removable"<< std::endl;
+  for(unsigned int i=0;i<ranked.size();i++){
+    const InstReuse& r = ranked[i].second;
+    os<< std::setw(6) << ranked[i].first << std::setw(12) << r.uses << std::setw(12) << r.cold
+      << std::setw(12) << r.misses << std::setw(12) << r.removable << std::endl;
+  }
+
+  static const char* kinds[REUSE_CLASSES] = {"intra-warp","intra-workgroup","inter-workgroup"};
+
+  os<<"\nReuse distance histograms, buckets 0, 1, 2-3, 4-7, ...\n";
+  for(unsigned int i=0;i<ranked.size();i++){
+    os<<"Instruction "<< ranked[i].first <<":\n";
+    for(int c=0;c<REUSE_CLASSES;c++){
+      const unsigned long* histogram = ranked[i].second.histogram[c];
+
+      //Trailing empty buckets are left out
+      unsigned int last = REUSE_BUCKETS;
+      while(last > 0 && histogram[last - 1] == 0)
+        last--;
+
+      os<<"  "<< std::setw(16) << std::left << kinds[c] << std::right;
+      for(unsigned int b=0;b<last;b++){
+        os<<" "<< histogram[b];
+      }
+      os<< std::endl;
+    }
+  }
+  os<< std::endl;
+
+  return os;
+}
@@ -0,0 +1,135 @@
+/*
+ * reuse.h
+ *
+ * Reuse distance profile of each instruction, used to pick the loads worth
+ * staging in local memory. Distances count the distinct cache lines touched
+ * between two uses of a line. Each reuse is classed as intra-warp when the
+ * workgroup last used the line from the same warp, intra-workgroup when from
+ * another of its warps, and inter-workgroup when only other workgroups used
+ * the line before.
+ */
+#ifndef REUSE_H
+#define REUSE_H
+
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+#include "stats.h"
+
+
+const unsigned int SCRATCHPAD_DEFAULT = 48;   //KB of local memory on a Fermi SM
+const unsigned int REUSE_BUCKETS = 33;        //Distance 0, then one bucket per power of two
+
+const int REUSE_WARP = 0;          //Reused by the warp of the workgroup which used the line last
+const int REUSE_WORKGROUP = 1;     //By another warp of the same workgroup
+const int REUSE_INTER = 2;         //First use by the workgroup of a line others used
+const int REUSE_CLASSES = 3;
+
+
+/*
+ * Binary indexed tree over access times, marking the last use of each
+ * line, so the lines used since a time are counted in O(log n).
+ * Times are appended as the trace is read.
+ */
+class Fenwick
+{
+  public:
+    // Appends time size()+1 holding value
+    void push(int value);
+
+    void add(unsigned int time, int delta);
+
+    // Sum over times 1 to time
+    int prefix(unsigned int time) const;
+
+    unsigned int size() const { return tree.size();}
+
+    void clear(){ tree.clear();}
+
+  private:
+    std::vector<int> tree;
+};
+
+
+/*
+ * Lines of one workgroup, to measure reuse within it alone
+ */
+struct ReuseWindow
+{
+   Fenwick marks;
+   std::unordered_map<unsigned long,unsigned int> last;   //Time of each line's last use
+   std::unordered_map<unsigned long,unsigned int> warps;  //Warp which last used each line
+
+   // Distinct lines used since the line's last use, -1 if never used
+   long touch(unsigned long line);
+};
+
+
+//Reuse of the lines an instruction touches
+struct InstReuse
+{
+   InstReuse():uses(0),cold(0),misses(0),removable(0){
+     for(int c=0;c<REUSE_CLASSES;c++)
+       for(unsigned int b=0;b<REUSE_BUCKETS;b++)
+         histogram[c][b] = 0;
+   }
+
+   unsigned long uses;         //Lines touched, once per warp instruction
+   unsigned long cold;         //First uses of a line
+   unsigned long misses;       //Uses missing a fully associative LRU cache of the same size
+   unsigned long removable;    //Misses a workgroup's scratchpad would hold
+   unsigned long histogram[REUSE_CLASSES][REUSE_BUCKETS];
+
+   InstReuse& operator+= (const InstReuse& right);
+};
+
+
+class ReuseProfile
+{
+  public:
+    // Cache and scratchpad capacities in lines of line_size bytes,
+    // profiling off if line_size is 0
+    ReuseProfile(unsigned int line_size = 0, unsigned int cache_lines = 0, unsigned int scratchpad_bytes = 0);
+
+    // Distances restart with the cache at each execution
+    void begin_execution(unsigned int warp_size);
+
+    // Global memory accesses in replay order
+    void access(const Entry& e);
+
+    void clear_counts();
+
+    ReuseProfile& operator+= (const ReuseProfile& right);
+
+    // Ranking of the instructions, then their histograms
+    friend std::ostream & operator<< (std::ostream & os, const ReuseProfile& right);
+
+    // reuse_misses and reuse_removable over all instructions
+    void getValues(std::vector<NamedStat>& values) const;
+
+    bool enabled() const { return line_size != 0;}
+
+  private:
+    void use(unsigned long line, const Entry& e);
+
+    unsigned int line_size;
+    unsigned int cache_lines;
+    unsigned int scratchpad_lines;
+
+    std::map<unsigned int,InstReuse> by_inst;
+
+    //Replay state of the current execution
+    ReuseWindow all;
+    std::unordered_map<unsigned int,ReuseWindow> by_wk;
+
+    //Lines of the warp instruction being read, counted once each
+    unsigned int warp_size;
+    bool in_group;
+    unsigned int group_wk,group_warp,group_inst,group_size;
+    std::vector<unsigned long> group_lines;
+};
+
+#endif
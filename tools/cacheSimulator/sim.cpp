@@ -0,0 +1,443 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+#include "sim.h"
+
+
+Report::Report(const Options& opts):use_ro(opts.ro_cache),use_dram(opts.dram),dram(opts.dram_config),tlb(opts.tlb),banks(opts.banks),
+    buffers(opts.buffers.get(),0){}
+
+Report& Report::operator+= (const Report& right){
+  stats += right.stats;
+  ro_stats += right.ro_stats;
+  dram += right.dram;
+  tlb += right.tlb;
+  banks += right.banks;
+  buffers += right.buffers;
+  reuse += right.reuse;
+  return *this;
+}
+
+std::ostream & operator<< (std::ostream & os, const Report& right){
+  os << right.stats;
+
+  if(right.use_ro){
+    os << "\n==================================\n";
+    os << "READ-ONLY CACHE";
+    os << right.ro_stats;
+  }
+
+  if(right.use_dram)
+    os << right.dram;
+
+  if(right.tlb.enabled())
+    os << right.tlb;
+
+  if(right.banks.used())
+    os << right.banks;
+
+  if(right.buffers.used())
+    os << right.buffers;
+
+  if(right.reuse.enabled())
+    os << right.reuse;
+
+  return os;
+}
+
+std::vector<NamedStat> Report::getValues() const{
+  std::vector<NamedStat> values;
+  stats.getValues(values);
+
+  if(use_ro){
+    std::vector<NamedStat> ro;
+    ro_stats.getValues(ro);
+    for(unsigned int i=0;i<ro.size();i++){
+      values.push_back(NamedStat("ro_" + ro[i].first,ro[i].second));
+    }
+  }
+
+  if(use_dram)
+    dram.getValues(values);
+
+  tlb.getValues(values);
+  banks.getValues(values);
+  buffers.getValues(values);
+  reuse.getValues(values);
+  return values;
+}
+
+void Report::print(std::ostream& os, const Options& opts) const{
+  if(opts.stats.empty()){
+    os << *this;
+    return;
+  }
+
+  std::vector<NamedStat> values = getValues();
+  for(unsigned int i=0;i<opts.stats.size();i++){
+    unsigned int v = 0;
+    while(v < values.size() && values[v].first != opts.stats[i])
+      v++;
+
+    if(v < values.size())
+      os << values[v].first << " " << std::setprecision(10) << values[v].second << std::endl;
+    else
+      os << opts.stats[i] << " unknown" << std::endl;
+  }
+}
+
+/*
+ * Two sided 95% critical value of Student's t distribution
+*/
+static double t_critical(unsigned int df){
+  static const double table[] = {12.706,4.303,3.182,2.776,2.571,2.447,2.365,2.306,2.262,2.228,
+                                 2.201,2.179,2.160,2.145,2.131,2.120,2.110,2.101,2.093,2.086,
+                                 2.080,2.074,2.069,2.064,2.060,2.056,2.052,2.048,2.045,2.042};
+  if(df == 0)
+    return 0;
+  if(df <= 30)
+    return table[df - 1];
+  if(df <= 60)
+    return 2.000;
+  if(df <= 120)
+    return 1.980;
+  return 1.960;
+}
+
+void print_replicas(std::ostream& os, const std::vector<Report>& replicas, const Options& opts){
+  if(replicas.empty())
+    return;
+
+  std::vector<std::vector<NamedStat> > values;
+  for(unsigned int r=0;r<replicas.size();r++){
+    values.push_back(replicas[r].getValues());
+  }
+
+  unsigned int n = replicas.size();
+  double t = t_critical(n - 1);
+
+  os<<"\n==================================\n";
+  os<<"REPLICAS\n";
+  os<<"==================================\n";
+  os<<"Replicas: "<< n <<", seed "<< opts.seed << std::endl;
+
+  for(unsigned int v=0;v<values[0].size();v++){
+    const std::string& name = values[0][v].first;
+    if(!opts.stats.empty() && std::find(opts.stats.begin(),opts.stats.end(),name) == opts.stats.end())
+      continue;
+
+    double mean = 0;
+    for(unsigned int r=0;r<n;r++){
+      mean += values[r][v].second;
+    }
+    mean /= n;
+
+    double variance = 0;
+    for(unsigned int r=0;r<n;r++){
+      variance += (values[r][v].second - mean) * (values[r][v].second - mean);
+    }
+    variance = n > 1 ? variance / (n - 1) : 0;
+
+    double half = t * std::sqrt(variance / n);
+
+    os << std::setprecision(10) << name <<": mean "<< mean <<", variance "<< variance
+       <<", 95% CI ["<< mean - half <<", "<< mean + half <<"]"<< std::endl;
+  }
+  os<<std::endl;
+}
+
+
+/*
+  Calculates the ceiling of a over b
+*/
+unsigned int ceiling(unsigned int a, unsigned int b){
+  
+   if(!a || !b)
+       return 0;
+
+   if(a% b ==0){
+     return a/ b;
+   }
+   else{
+     return (a/b) +1;
+   }
+}
+
+//calculate workgroups to process based on total number of workgroups
+std::vector<unsigned int>get_workgroups(unsigned int total_wk,std::mt19937& rng){
+
+  std::vector<unsigned int> workgroups;
+
+  //calculate how many workgroups will be processed on each core
+  unsigned int sim_num = ceiling(total_wk,CORES);
+
+  // if only one workgroup per core, process first workgroup
+  if(sim_num == 1){
+   workgroups.push_back(0);
+   return workgroups;
+  }
+
+  //Picks workgroups at random to simulate, provided they are not duplicates
+  std::uniform_int_distribution<unsigned int> pick(0,total_wk - 1);
+  for(unsigned int i=0;i<sim_num;i++){
+      unsigned int added = pick(rng);
+      while(std::find(workgroups.begin(),workgroups.end(),added) != workgroups.end() ){
+          added = pick(rng);
+      }
+      workgroups.push_back(added);
+  }
+
+  return workgroups;
+
+}
+
+
+Simulator::Simulator(const CacheConfig& config, const Options& o, unsigned int r):
+    opts(o),replica(r),cache(config),dram(o.dram_config),tlb(o.tlb),banks(o.banks),
+    buffers(o.buffers.get(),config.line_size),
+    reuse(o.reuse ? config.line_size : 0,config.num_lines,o.scratchpad * 1024),
+    working_set(o.working_set,config.line_size),index(0){
+
+  //Random replacement draws from a stream of its own
+  std::seed_seq seed = {(unsigned int)opts.seed,(unsigned int)(opts.seed >> 32),replica,~0u};
+  cache.rng.seed(seed);
+
+  if(opts.ro_cache){
+    ro_cache.reset(new Cache(opts.ro_config));
+    ro_cache->rng.seed(cache.rng());
+  }
+
+  if(opts.dram){
+    cache.attach(&dram);
+    if(ro_cache)
+      ro_cache->attach(&dram);
+  }
+
+  if(!opts.miss_file.empty()){
+    misses.open();
+    cache.attach(&misses);
+    if(ro_cache)
+      ro_cache->attach(&misses);
+  }
+}
+
+/*
+ *  Simulates a single access
+*/
+void Simulator::access(const Entry& e){
+  //Stores of the previous warp instruction are sent before the miss
+  //stream moves on to this access
+  cache.flush_writes(e.warp_id,e.inst);
+  misses.set_access(e,index++);
+
+  //Local memory bypasses the cache
+  if(e.op & OP_LOCAL){
+    banks.access(e);
+    return;
+  }
+
+  if(reuse.enabled())
+    reuse.access(e);
+
+  //Sampled workgroups all run on the one simulated core
+  if(tlb.enabled())
+    tlb.access(e,opts.all ? e.wk_id % CORES : 0);
+  if(working_set.enabled())
+    working_set.access(e,opts.all ? e.wk_id % CORES : 0);
+
+  //Attributes the requests the cache counts, one per line a warp instruction touches
+  int accesses = 0, before = 0;
+  if(buffers.used()){
+    accesses = num_accesses();
+    before = num_misses();
+  }
+
+  if(read_only(e))
+    ro_cache->read(e.address,e.warp_id,e.inst);    //Read-only cache read
+  else if(e.op & OP_READ)
+    cache.read(e.address,e.warp_id,e.inst);        //Cache read
+  else
+    cache.write(e.address,e.warp_id,e.inst);       //Cache write
+
+  if(buffers.used())
+    buffers.access(e,num_accesses() > accesses,num_misses() > before);
+}
+
+/*
+ *  Whether a load goes through the read-only cache, as -ro routes them:
+ *  marked read-only in the trace, listed by instruction, or none
+*/
+bool Simulator::read_only(const Entry& e) const{
+  if(!ro_cache || !(e.op & OP_READ))
+    return false;
+
+  if(opts.ro_route == RO_AUTO)
+    return e.op & OP_READONLY;
+  if(opts.ro_route == RO_LISTED)
+    return std::find(opts.ro_insts.begin(),opts.ro_insts.end(),e.inst) != opts.ro_insts.end();
+  return false;
+}
+
+int Simulator::num_misses() const{
+  int total = cache.stats.getNumMisses();
+  if(ro_cache)
+    total += ro_cache->stats.getNumMisses();
+  return total;
+}
+
+int Simulator::num_accesses() const{
+  int total = cache.stats.getNumAccess();
+  if(ro_cache)
+    total += ro_cache->stats.getNumAccess();
+  return total;
+}
+
+/*
+ *  Runs the sampled workgroups of a single execution through the simulator
+*/
+void Simulator::run(const Execution& exec, unsigned int n){
+  begin_execution(exec.warp_size,exec.total_wk,n);
+  replay(exec,n);
+  end_execution();
+}
+
+void Simulator::begin_execution(unsigned int warp_size, unsigned int total_wk, unsigned int n){
+
+  cache.warp_size = warp_size;
+  cache.reset_memory();
+
+  if(ro_cache){
+    ro_cache->warp_size = warp_size;
+    ro_cache->reset_memory();
+  }
+
+  index = 0;
+  misses.begin(warp_size,total_wk);
+  tlb.begin_execution();
+  buffers.begin_execution(n);
+  if(reuse.enabled())
+    reuse.begin_execution(warp_size);
+  if(working_set.enabled())
+    working_set.begin_execution(n,warp_size);
+}
+
+void Simulator::end_execution(){
+  //The execution's stores all reach memory before the next one starts
+  cache.flush_writes();
+  cache.flush_dirty();
+  banks.flush();
+  if(working_set.enabled())
+    working_set.end_execution();
+}
+
+void Simulator::replay(const Execution& exec, unsigned int n){
+
+  //Replay whole trace in order
+  if(opts.all){
+    Execution::Reader reader(exec);
+    Entry e;
+    while(reader.next(e)){
+      access(e);
+    }
+    return;
+  }
+
+  //The sample depends only on the seed, replica and execution, so it is
+  //the same however executions are spread over threads
+  std::vector<unsigned int> workgroups = opts.workgroups;
+  if(workgroups.empty()){
+    std::seed_seq seed = {(unsigned int)opts.seed,(unsigned int)(opts.seed >> 32),replica,n};
+    std::mt19937 rng(seed);
+    workgroups = get_workgroups(exec.total_wk,rng);
+  }
+
+  //Several workgroups resident, their warps' instructions interleaved
+  if(opts.occupancy.resident){
+    Interleaver interleaver(opts.occupancy);
+    interleaver.load(exec,workgroups);
+
+    interleaver.run([this](const Entry* first, const Entry* last){
+      int before = num_misses();
+      for(const Entry* e = first; e != last; ++e){
+        access(*e);
+      }
+      return num_misses() > before;
+    });
+    return;
+  }
+
+  for(unsigned int w=0;w<workgroups.size();w++){
+    //for every entry in workgroup
+    Execution::Reader reader(exec);
+    Entry e;
+    while(reader.next(e)){
+
+        //check if entry is in current workgroup
+        if(e.wk_id == workgroups.at(w)){
+          //Process with simulator
+          access(e);
+        }
+    }
+  }
+}
+
+void Simulator::clear_counts(){
+  cache.stats.clear_counts();
+  if(ro_cache)
+    ro_cache->stats.clear_counts();
+  dram.clear_counts();
+  tlb.clear_counts();
+  banks.clear_counts();
+  buffers.clear_counts();
+  reuse.clear_counts();
+  misses.clear();
+  working_set.clear();
+}
+
+std::string Simulator::take_misses(){
+  return misses.take();
+}
+
+std::string Simulator::take_working_set(){
+  return working_set.take();
+}
+
+Report Simulator::report() const{
+  Report r(opts);
+  r.stats += cache.stats;
+  if(ro_cache)
+    r.ro_stats += ro_cache->stats;
+  r.dram += dram;
+  r.tlb += tlb;
+  r.banks += banks;
+  r.buffers += buffers;
+  r.reuse += reuse;
+  return r;
+}
+
+void Simulator::print_tlb(std::ostream& os) const{
+  if(tlb.enabled())
+    tlb.print_execution(os);
+}
@@ -0,0 +1,128 @@
+/*
+ * sim.h
+ *
+ * The cache of a simulated core together with the models fed by it.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <iostream>
+#include <memory>
+
+#include "attribution.h"
+#include "banks.h"
+#include "cache.h"
+#include "dram.h"
+#include "interleave.h"
+#include "misses.h"
+#include "parse.h"
+#include "reuse.h"
+#include "stats.h"
+#include "store.h"
+#include "tlb.h"
+#include "workingset.h"
+
+
+/*
+ * Counters gathered by a simulator, which can be summed over executions.
+ */
+class Report
+{
+  public:
+    Report(const Options& opts);
+
+    Report& operator+= (const Report& right);
+
+    friend std::ostream & operator<< (std::ostream & os, const Report& right);
+
+    // Every counter and rate of the models in use, by name
+    std::vector<NamedStat> getValues() const;
+
+    // Prints the statistics named by the options, or the whole report
+    void print(std::ostream& os, const Options& opts) const;
+
+    Stats stats;
+    bool use_ro;
+    Stats ro_stats;           //Read-only cache
+    bool use_dram;
+    Dram dram;
+    Tlb tlb;
+    Banks banks;
+    BufferStats buffers;
+    ReuseProfile reuse;
+};
+
+
+/*
+ * Prints the mean, variance and 95% confidence interval of each statistic
+ * over the reports of independent replicas.
+ */
+void print_replicas(std::ostream& os, const std::vector<Report>& replicas, const Options& opts);
+
+
+class Simulator
+{
+  public:
+    Simulator(const CacheConfig& config, const Options& opts, unsigned int replica = 0);
+
+    /*
+     * Replays the sampled workgroups of execution n.
+     */
+    void run(const Execution& exec, unsigned int n);
+
+    /*
+     * Replays execution n record by record, for callers producing its
+     * accesses as they go rather than storing them: begin_execution,
+     * access for every access in trace order, then end_execution.
+     * No workgroups are sampled, as with -all.
+     */
+    void begin_execution(unsigned int warp_size, unsigned int total_wk, unsigned int n);
+    void access(const Entry& e);
+    void end_execution();
+
+    // Zeroes the counters, keeping the contents of the cache and DRAM rows
+    void clear_counts();
+
+    // Records of the miss stream since the last call
+    std::string take_misses();
+
+    // Samples of the working set series since the last call
+    std::string take_working_set();
+
+    Report report() const;
+
+    // TLB miss rates of the last execution run
+    void print_tlb(std::ostream& os) const;
+
+  private:
+    Simulator(const Simulator&);       //Not copyable, cache has the DRAM attached
+    Simulator& operator=(const Simulator&);
+
+    void replay(const Execution& exec, unsigned int n);
+
+    // Whether a load takes the read-only data path
+    bool read_only(const Entry& e) const;
+
+    // Misses of the caches so far
+    int num_misses() const;
+
+    // Requests of the caches so far
+    int num_accesses() const;
+
+    const Options& opts;
+    unsigned int replica;    //Picks the random streams used for sampling
+
+    Cache cache;
+    std::unique_ptr<Cache> ro_cache;     //Read-only data path, if modelled
+    Dram dram;
+    MissStream misses;
+    Tlb tlb;
+    Banks banks;
+    BufferStats buffers;
+    ReuseProfile reuse;
+    WorkingSet working_set;
+
+    unsigned long index;     //Accesses simulated in the current execution
+};
+
+#endif
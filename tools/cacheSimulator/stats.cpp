@@ -32,6 +32,31 @@ Stats::Stats(){
   coldMisses = 0;                       
   capacityMisses = 0;                 
   conflictMisses = 0;
+  dramReadBytes = 0;
+  dramWriteBytes = 0;
+  partialWrites = 0;
+}
+
+Stats& Stats::operator+= (const Stats& right){
+  reads += right.reads;
+  readMisses += right.readMisses;
+  writes += right.writes;
+  writeMisses += right.writeMisses;
+  writeBacks += right.writeBacks;
+  coldMisses += right.coldMisses;
+  capacityMisses += right.capacityMisses;
+  conflictMisses += right.conflictMisses;
+  dramReadBytes += right.dramReadBytes;
+  dramWriteBytes += right.dramWriteBytes;
+  partialWrites += right.partialWrites;
+  return *this;
+}
+
+void Stats::clear_counts(){
+  std::stack<StackEntry> keep;
+  keep.swap(stack);
+  *this = Stats();
+  stack.swap(keep);
 }
 
 void Stats::incrementReads(){
@@ -67,6 +92,17 @@ void Stats::incrementWriteBacks(){
 	  ++writeBacks;
 }
 
+void Stats::addDramRead(unsigned int bytes){
+    dramReadBytes += bytes;
+}
+
+void Stats::addDramWrite(unsigned int bytes,unsigned int line_size){
+    dramWriteBytes += bytes;
+
+    if(bytes < line_size)
+      ++partialWrites;
+}
+
 /*
  * returns the total number of cache accesses
 */
@@ -74,6 +110,13 @@ int Stats::getNumAccess()const{
 	return (reads + writes);
 }
 
+/*
+ * returns the total number of cache misses
+*/
+int Stats::getNumMisses()const{
+	return (readMisses + writeMisses);
+}
+
 /*
  * returns the read miss rate
 */
@@ -101,6 +144,23 @@ double Stats::getTotalMissRate()const{
    return ((double)(writeMisses + readMisses) / ((double)getNumAccess()));
 }
 
+void Stats::getValues(std::vector<NamedStat>& values)const{
+  values.push_back(NamedStat("reads",reads));
+  values.push_back(NamedStat("read_misses",readMisses));
+  values.push_back(NamedStat("writes",writes));
+  values.push_back(NamedStat("write_misses",writeMisses));
+  values.push_back(NamedStat("write_backs",writeBacks));
+  values.push_back(NamedStat("cold_misses",coldMisses));
+  values.push_back(NamedStat("capacity_misses",capacityMisses));
+  values.push_back(NamedStat("conflict_misses",conflictMisses));
+  values.push_back(NamedStat("dram_read_bytes",dramReadBytes));
+  values.push_back(NamedStat("dram_write_bytes",dramWriteBytes));
+  values.push_back(NamedStat("partial_writes",partialWrites));
+  values.push_back(NamedStat("read_miss_rate",getReadMissRate()));
+  values.push_back(NamedStat("write_miss_rate",getWriteMissRate()));
+  values.push_back(NamedStat("miss_rate",getTotalMissRate()));
+}
+
 std::ostream & operator<< (std::ostream & os, const Stats& right){
   os<<"\n==================================\n";
   os<<"RESULTS\n";
@@ -112,6 +172,9 @@ std::ostream & operator<< (std::ostream & os, const Stats& right){
   os<<"Cold Misses:     "<<right.coldMisses << std::endl;
   os<<"Capacity Misses: "<<right.capacityMisses << std::endl;
   os<<"Conflict Misses: "<<right.conflictMisses << std::endl;
+  os<<"DRAM Read Bytes: "<<right.dramReadBytes << std::endl;
+  os<<"DRAM Write Bytes:"<<right.dramWriteBytes << std::endl;
+  os<<"Partial Writes:  "<<right.partialWrites << std::endl;
   os<<"Read  Miss Rate: "<<right.getReadMissRate() << std::endl;
   os<<"Write Miss Rate: "<<right.getWriteMissRate() << std::endl;
   os<<"Total Miss Rate: "<<right.getTotalMissRate() << std::endl<< std::endl;
@@ -136,6 +199,9 @@ void Stats::Write(){
   output << "Cold Misses:     " << coldMisses << std::endl;
   output << "Capacity Misses: " << capacityMisses << std::endl;
   output << "Conflict Misses: " << conflictMisses << std::endl;
+  output << "DRAM Read Bytes: " << dramReadBytes << std::endl;
+  output << "DRAM Write Bytes:" << dramWriteBytes << std::endl;
+  output << "Partial Writes:  " << partialWrites << std::endl;
   output << "Read  Miss Rate: " << getReadMissRate() << std::endl;
   output << "Write Miss Rate: " << getWriteMissRate() << std::endl;
   output << "Total Miss Rate: " << getTotalMissRate() << std::endl;
@@ -4,10 +4,16 @@
 #include <cstdint>
 #include <stack>
 #include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
 
 
 const unsigned int Infinity = 2000000000;
 
+//A counter or rate by name, so statistics can be picked out and aggregated
+typedef std::pair<std::string,double> NamedStat;
+
 
 //reuse stack entry 
 class StackEntry
@@ -34,6 +40,9 @@ class Stats
     int coldMisses;                     // Number of cold misses   
     int capacityMisses;                 // Number of capactiy misses
     int conflictMisses;                 // Number of conflict misses
+    unsigned long long dramReadBytes;   // Bytes read from DRAM
+    unsigned long long dramWriteBytes;  // Bytes written to DRAM
+    unsigned long long partialWrites;   // Writes to DRAM smaller than a line
     std::stack<StackEntry> stack;       //cache line reuse distance stack
 
    public:
@@ -42,6 +51,13 @@ class Stats
    
    friend std::ostream & operator<< (std::ostream & os, const Stats& right);
 
+   // Adds the counters of another set of stats, used to aggregate executions
+   Stats& operator+= (const Stats& right);
+
+   // Zeroes the counters but keeps the reuse stack, so a warmed up
+   // cache still classifies its misses correctly
+   void clear_counts();
+
    void Write();
 
    void incrementReads();
@@ -49,11 +65,17 @@ class Stats
    void incrementWrites();
    void incrementWriteMisses();
    void incrementWriteBacks();
+   void addDramRead(unsigned int bytes);
+   void addDramWrite(unsigned int bytes,unsigned int line_size);
    int getNumAccess()const;
+   int getNumMisses()const;
    double getReadMissRate()const;
    double getWriteMissRate()const;
    double getTotalMissRate()const;
 
+   // Every counter and rate, by name
+   void getValues(std::vector<NamedStat>& values)const;
+
    unsigned int stackRef(intptr_t tag,int set);
 
 
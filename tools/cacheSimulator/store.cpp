@@ -0,0 +1,234 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include "store.h"
+
+
+Arena::Arena(){
+  used = ARENA_SLAB_SIZE;
+}
+
+Arena::~Arena(){
+  for(unsigned int i=0;i<slabs.size();i++){
+    delete[] slabs[i];
+  }
+}
+
+/*
+ * Returns memory from the current slab, starting a new slab if the
+ * request doesn't fit.
+*/
+unsigned char* Arena::allocate(size_t bytes){
+
+  if(bytes > ARENA_SLAB_SIZE){   //Oversized requests get a slab of their own
+    slabs.push_back(new unsigned char[bytes]);
+    used = ARENA_SLAB_SIZE;
+    return slabs.back();
+  }
+
+  if(used + bytes > ARENA_SLAB_SIZE){
+    slabs.push_back(new unsigned char[ARENA_SLAB_SIZE]);
+    used = 0;
+  }
+
+  unsigned char* ptr = slabs.back() + used;
+  used += bytes;
+  return ptr;
+}
+
+size_t Arena::capacity() const{
+  return slabs.size() * ARENA_SLAB_SIZE;
+}
+
+
+Column::Column(){
+  tail = COLUMN_BLOCK_SIZE;
+}
+
+void Column::push(unsigned char byte, Arena& arena){
+  if(tail == COLUMN_BLOCK_SIZE){
+    blocks.push_back(arena.allocate(COLUMN_BLOCK_SIZE));
+    tail = 0;
+  }
+  blocks.back()[tail++] = byte;
+}
+
+void Column::push_varint(unsigned long long value, Arena& arena){
+  while(value >= 0x80){
+    push((unsigned char)(value | 0x80),arena);
+    value >>= 7;
+  }
+  push((unsigned char)value,arena);
+}
+
+void Column::push_fixed(unsigned int value, unsigned int width, Arena& arena){
+  for(unsigned int i=0;i<width;i++){
+    push((unsigned char)(value >> (8 * i)),arena);
+  }
+}
+
+/*
+ * Number of bytes in the column
+*/
+size_t Column::size() const{
+  if(blocks.empty())
+    return 0;
+  return (blocks.size() - 1) * COLUMN_BLOCK_SIZE + tail;
+}
+
+Column::Reader::Reader(const Column& col):column(&col),block(0),offset(0){}
+
+unsigned char Column::Reader::next(){
+  if(offset == COLUMN_BLOCK_SIZE){
+    ++block;
+    offset = 0;
+  }
+  return column->blocks[block][offset++];
+}
+
+unsigned long long Column::Reader::varint(){
+  unsigned long long value = 0;
+  unsigned int shift = 0;
+  unsigned char byte;
+  do{
+    byte = next();
+    value |= (unsigned long long)(byte & 0x7F) << shift;
+    shift += 7;
+  }while(byte & 0x80);
+
+  return value;
+}
+
+unsigned int Column::Reader::fixed(unsigned int width){
+  unsigned int value = 0;
+  for(unsigned int i=0;i<width;i++){
+    value |= (unsigned int)next() << (8 * i);
+  }
+  return value;
+}
+
+
+/*
+ * Number of bytes needed to store values less than 'n'
+*/
+static unsigned int width_for(unsigned long long n){
+  if(n <= 0x100)
+    return 1;
+  if(n <= 0x10000)
+    return 2;
+  return 4;
+}
+
+/*
+ * Maps signed deltas onto unsigned values so small magnitudes
+ * of either sign encode in few bytes.
+*/
+static unsigned int zigzag(int value){
+  return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+}
+
+static int unzigzag(unsigned int value){
+  return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+
+Execution::Execution(unsigned int warp, unsigned int wk):
+   warp_size(warp),total_wk(wk),last_warp(0),count(0){
+
+  wk_width = width_for(total_wk);
+}
+
+/*
+ * Appends an access to the execution
+*/
+void Execution::push(const Entry& e){
+
+  if(width_for((unsigned long long)e.wk_id + 1) > wk_width)
+    widen_wk(e.wk_id);
+
+  unsigned int space = e.warp_id * 2 + ((e.op & OP_LOCAL) ? 1 : 0);
+  if(space >= last_addr.size())
+    last_addr.resize(space + 2,0);
+
+  //address delta from last access in warp, with op in the low bits
+  int delta = (int)(e.address - last_addr[space]);
+  unsigned long long addr = ((unsigned long long)zigzag(delta) << 3) | (e.op & 7);
+  last_addr[space] = e.address;
+
+  addr_col.push_varint(addr,arena);
+  wk_col.push_fixed(e.wk_id,wk_width,arena);
+  warp_col.push_varint(zigzag((int)(e.warp_id - last_warp)),arena);
+  inst_col.push_varint(e.inst,arena);
+
+  last_warp = e.warp_id;
+  ++count;
+}
+
+/*
+ * Re-encodes the workgroup column when an id doesn't fit the width
+ * given by the trace header.
+*/
+void Execution::widen_wk(unsigned int id){
+  unsigned int width = width_for((unsigned long long)id + 1);
+
+  Column widened;
+  Column::Reader reader(wk_col);
+  for(size_t i=0;i<count;i++){
+    widened.push_fixed(reader.fixed(wk_width),width,arena);
+  }
+
+  wk_col = widened;
+  wk_width = width;
+}
+
+size_t Execution::bytes() const{
+  return addr_col.size() + wk_col.size() + warp_col.size() + inst_col.size();
+}
+
+
+Execution::Reader::Reader(const Execution& e):
+   exec(&e),addr(e.addr_col),wk(e.wk_col),warp(e.warp_col),inst(e.inst_col),
+   remaining(e.count),last_addr(e.last_addr.size(),0),last_warp(0){}
+
+/*
+ * Decodes the next access into 'e', returning false once every
+ * access has been read.
+*/
+bool Execution::Reader::next(Entry& e){
+  if(remaining == 0)
+    return false;
+  --remaining;
+
+  unsigned long long a = addr.varint();
+
+  e.warp_id = last_warp + unzigzag((unsigned int)warp.varint());
+  e.op = a & 7;
+
+  unsigned int space = e.warp_id * 2 + ((e.op & OP_LOCAL) ? 1 : 0);
+  e.address = last_addr[space] + unzigzag((unsigned int)(a >> 3));
+  e.wk_id = wk.fixed(exec->wk_width);
+  e.inst = (unsigned int)inst.varint();
+
+  last_addr[space] = e.address;
+  last_warp = e.warp_id;
+
+  return true;
+}
@@ -0,0 +1,143 @@
+/*
+ * store.h
+ *
+ * Compact in-memory representation of the accesses made by a kernel
+ * execution. Accesses are kept column by column in blocks taken from an
+ * arena, rather than as one heap node per access.
+ */
+#ifndef STORE_H
+#define STORE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "common.h"
+
+
+const size_t ARENA_SLAB_SIZE = 1 << 20;   //Bytes reserved from the system at a time
+const size_t COLUMN_BLOCK_SIZE = 1 << 12; //Bytes in each block of a column
+
+
+/*
+ * Bump allocator which hands out memory from large slabs. Nothing is freed
+ * until the arena itself is destroyed.
+ */
+class Arena
+{
+  public:
+    Arena();
+    ~Arena();
+
+    unsigned char* allocate(size_t bytes);
+
+    size_t capacity() const;           //Total bytes reserved from the system
+
+  private:
+    Arena(const Arena&);               //Not copyable
+    Arena& operator=(const Arena&);
+
+    std::vector<unsigned char*> slabs;
+    size_t used;                       //Bytes handed out from the last slab
+};
+
+
+/*
+ * Append only stream of bytes, stored as a chain of fixed size blocks
+ * allocated from an arena.
+ */
+class Column
+{
+  public:
+    Column();
+
+    void push(unsigned char byte, Arena& arena);
+
+    // Variable length encoding, 7 bits per byte, low bits first
+    void push_varint(unsigned long long value, Arena& arena);
+
+    // Little endian encoding in 'width' bytes
+    void push_fixed(unsigned int value, unsigned int width, Arena& arena);
+
+    size_t size() const;
+
+    // Reads back the bytes of a column in the order they were pushed
+    class Reader
+    {
+      public:
+        Reader(const Column& column);
+
+        unsigned char next();
+        unsigned long long varint();
+        unsigned int fixed(unsigned int width);
+
+      private:
+        const Column* column;
+        size_t block;                  //Current block
+        size_t offset;                 //Offset in current block
+    };
+
+  private:
+    std::vector<unsigned char*> blocks;
+    size_t tail;                       //Bytes used in the last block
+};
+
+
+/*
+ * Accesses from a single kernel execution.
+ *
+ * Workgroup ids are stored in the fewest bytes that fit the number of
+ * workgroups given in the trace header. Addresses are delta encoded against
+ * the previous access of the same warp to the same address space, with
+ * the op bits folded into the low three bits. Warp ids are delta encoded against the previous access
+ * and instruction ids are stored as varints.
+ */
+class Execution
+{
+  public:
+    Execution(unsigned int warp_size, unsigned int total_wk);
+
+    void push(const Entry& e);
+
+    size_t size() const { return count; }   //Number of accesses
+    size_t bytes() const;                   //Bytes used to store the accesses
+
+    // Decodes the accesses of an execution in trace order
+    class Reader
+    {
+      public:
+        Reader(const Execution& exec);
+
+        bool next(Entry& e);
+
+      private:
+        const Execution* exec;
+        Column::Reader addr, wk, warp, inst;
+        size_t remaining;
+        std::vector<unsigned int> last_addr;
+        unsigned int last_warp;
+    };
+
+    unsigned int warp_size;                 //Threads in a warp
+    unsigned int total_wk;                  //Workgroups in the execution
+
+  private:
+    Execution(const Execution&);            //Not copyable
+    Execution& operator=(const Execution&);
+
+    void widen_wk(unsigned int id);
+
+    Arena arena;
+
+    Column addr_col;
+    Column wk_col;
+    Column warp_col;
+    Column inst_col;
+
+    unsigned int wk_width;                  //Bytes per workgroup id
+
+    std::vector<unsigned int> last_addr;    //Last address accessed by each warp, global then local
+    unsigned int last_warp;                 //Warp of the last access
+    size_t count;
+};
+
+#endif
@@ -0,0 +1,170 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+#include <sstream>
+
+#include "tlb.h"
+
+
+TlbLevel::TlbLevel(const TlbConfig& c):config(c){
+  num_sets = config.entries / config.associativity;
+
+  unsigned int copies = config.shared ? 1 : CORES;
+  entries.assign(copies * config.entries,-1);
+}
+
+/*
+ * Sets are kept in most recently used order, so replacement is LRU.
+*/
+bool TlbLevel::lookup(unsigned long page, unsigned int core){
+
+  unsigned int copy = config.shared ? 0 : core % CORES;
+  unsigned int set = page % num_sets;
+
+  std::vector<long>::iterator first = entries.begin() +
+      copy * config.entries + set * config.associativity;
+  std::vector<long>::iterator last = first + config.associativity;
+
+  std::vector<long>::iterator match = std::find(first,last,(long)page);
+  bool hit = (match != last);
+
+  if(!hit)
+    match = last - 1;               //Replace least recently used
+
+  //Move entry to the front of the set
+  std::copy_backward(first,match,match + 1);
+  *first = page;
+
+  return hit;
+}
+
+
+Tlb::Tlb(const std::vector<TlbConfig>& configs):last_warp(0),last_inst(0){
+  for(unsigned int i=0;i<configs.size();i++){
+    levels.push_back(TlbLevel(configs[i]));
+  }
+
+  totals.resize(levels.size());
+  execution.resize(levels.size());
+  by_inst.resize(levels.size());
+}
+
+void Tlb::access(const Entry& e, unsigned int core){
+
+  if(e.warp_id != last_warp || e.inst != last_inst){
+    warp_pages.clear();
+    last_warp = e.warp_id;
+    last_inst = e.inst;
+  }
+
+  unsigned long page = e.address / levels[0].config.page_size;
+  if(std::find(warp_pages.begin(),warp_pages.end(),page) != warp_pages.end())
+    return;
+  warp_pages.push_back(page);
+
+  //Each level is only looked up when the levels above it miss
+  for(unsigned int l=0;l<levels.size();l++){
+    page = e.address / levels[l].config.page_size;
+
+    bool hit = levels[l].lookup(page,core);
+
+    TlbCount& inst = by_inst[l][e.inst];
+    ++totals[l].lookups;
+    ++execution[l].lookups;
+    ++inst.lookups;
+
+    if(hit)
+      break;
+
+    ++totals[l].misses;
+    ++execution[l].misses;
+    ++inst.misses;
+  }
+}
+
+void Tlb::begin_execution(){
+  execution.assign(levels.size(),TlbCount());
+  warp_pages.clear();
+}
+
+void Tlb::clear_counts(){
+  totals.assign(levels.size(),TlbCount());
+  execution.assign(levels.size(),TlbCount());
+  by_inst.assign(levels.size(),std::map<unsigned int,TlbCount>());
+}
+
+Tlb& Tlb::operator+= (const Tlb& right){
+  for(unsigned int l=0;l<totals.size() && l<right.totals.size();l++){
+    totals[l].lookups += right.totals[l].lookups;
+    totals[l].misses += right.totals[l].misses;
+    execution[l].lookups += right.execution[l].lookups;
+    execution[l].misses += right.execution[l].misses;
+
+    for(std::map<unsigned int,TlbCount>::const_iterator iter = right.by_inst[l].begin(),
+        end = right.by_inst[l].end(); iter != end; ++iter){
+      by_inst[l][iter->first].lookups += iter->second.lookups;
+      by_inst[l][iter->first].misses += iter->second.misses;
+    }
+  }
+  return *this;
+}
+
+void Tlb::print_execution(std::ostream& os) const{
+  for(unsigned int l=0;l<execution.size();l++){
+    os<<"TLB L"<< l+1 <<" Miss Rate: "<<execution[l].getMissRate()
+      <<" ("<<execution[l].misses<<" of "<<execution[l].lookups<<")"<<std::endl;
+  }
+}
+
+void Tlb::getValues(std::vector<NamedStat>& values) const{
+  for(unsigned int l=0;l<totals.size();l++){
+    std::ostringstream level;
+    level << "tlb_l" << l+1 << "_";
+    values.push_back(NamedStat(level.str() + "lookups",totals[l].lookups));
+    values.push_back(NamedStat(level.str() + "misses",totals[l].misses));
+    values.push_back(NamedStat(level.str() + "miss_rate",totals[l].getMissRate()));
+  }
+}
+
+std::ostream & operator<< (std::ostream & os, const Tlb& right){
+  os<<"\n==================================\n";
+  os<<"TLB\n";
+  os<<"==================================\n";
+
+  for(unsigned int l=0;l<right.levels.size();l++){
+    const TlbConfig& c = right.levels[l].config;
+    os<<"L"<< l+1 <<": "<< c.entries <<" entries, "<< c.associativity <<" way, "
+      << c.page_size <<" byte pages, "<< (c.shared ? "shared" : "per core") << std::endl;
+    os<<"  Lookups:   "<< right.totals[l].lookups << std::endl;
+    os<<"  Misses:    "<< right.totals[l].misses << std::endl;
+    os<<"  Miss Rate: "<< right.totals[l].getMissRate() << std::endl;
+
+    for(std::map<unsigned int,TlbCount>::const_iterator iter = right.by_inst[l].begin(),
+        end = right.by_inst[l].end(); iter != end; ++iter){
+      os<<"  Instruction "<< iter->first <<": "<< iter->second.misses <<" of "
+        << iter->second.lookups <<" missed, rate "<< iter->second.getMissRate() << std::endl;
+    }
+  }
+  os<<std::endl;
+
+  return os;
+}
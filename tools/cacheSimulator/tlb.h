@@ -0,0 +1,105 @@
+/*
+ * tlb.h
+ *
+ * Multi-level TLB model, run alongside the cache on the same address stream.
+ */
+#ifndef TLB_H
+#define TLB_H
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "common.h"
+#include "stats.h"
+
+
+/*
+ * Configuration of one level of the TLB.
+ */
+struct TlbConfig
+{
+   unsigned int entries;
+   unsigned int associativity;
+   unsigned int page_size;        //Bytes in a page
+   bool shared;                   //One TLB for all cores, rather than one per core
+};
+
+
+//Lookups and misses, kept for a TLB level and for each instruction
+struct TlbCount
+{
+   TlbCount():lookups(0),misses(0){}
+
+   unsigned long lookups;
+   unsigned long misses;
+
+   double getMissRate() const { return lookups ? (double)misses / lookups : 0;}
+};
+
+
+/*
+ * One level of the TLB. Per core levels keep a separate set of entries
+ * for each of the CORES cores.
+ */
+class TlbLevel
+{
+  public:
+    TlbLevel(const TlbConfig& config);
+
+    /*
+     * Looks up the page for a core, filling it on a miss. Returns true on a hit.
+     */
+    bool lookup(unsigned long page, unsigned int core);
+
+    TlbConfig config;
+
+  private:
+    unsigned int num_sets;
+    std::vector<long> entries;     //Pages in each set, most recently used first
+};
+
+
+class Tlb
+{
+  public:
+    Tlb(const std::vector<TlbConfig>& levels);
+
+    /*
+     * Translates the address of an access made on 'core'. Accesses from
+     * the same warp instruction to the same page share a single lookup.
+     */
+    void access(const Entry& e, unsigned int core);
+
+    // Starts counting the misses of a new execution
+    void begin_execution();
+
+    // Zeroes the counters, keeping the translations held
+    void clear_counts();
+
+    Tlb& operator+= (const Tlb& right);
+
+    // Miss rates of each level for the current execution
+    void print_execution(std::ostream& os) const;
+
+    friend std::ostream & operator<< (std::ostream & os, const Tlb& right);
+
+    // Lookups, misses and miss rate of each level, by name
+    void getValues(std::vector<NamedStat>& values) const;
+
+    bool enabled() const { return !levels.empty();}
+
+  private:
+    std::vector<TlbLevel> levels;
+
+    std::vector<TlbCount> totals;                           //Per level
+    std::vector<TlbCount> execution;                        //Per level, current execution
+    std::vector<std::map<unsigned int,TlbCount> > by_inst;  //Per level, for each instruction
+
+    //Pages already looked up by the current warp instruction
+    std::vector<unsigned long> warp_pages;
+    unsigned int last_warp;
+    unsigned int last_inst;
+};
+
+#endif
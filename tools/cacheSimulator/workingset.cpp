@@ -0,0 +1,103 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+
+#include "workingset.h"
+
+
+WorkingSet::WorkingSet(const WorkingSetConfig& c, unsigned int line):
+    config(c),line_size(line),execution(0),warp_size(0){}
+
+void WorkingSet::begin_execution(unsigned int n, unsigned int warp){
+  if(n == 0)
+    out << "# execution core time lines" << std::endl;
+
+  execution = n;
+  warp_size = warp;
+  cores.assign(CORES,Core());
+}
+
+void WorkingSet::access(const Entry& e, unsigned int core){
+  Core& c = cores[core % CORES];
+  unsigned long line = e.address / line_size;
+
+  if(!config.warp){
+    push(c,core,&line,1);
+    return;
+  }
+
+  //Lines of a warp instruction enter the window together
+  if(c.open && (e.wk_id != c.wk || e.warp_id != c.warp || e.inst != c.inst || c.size == warp_size)){
+    push(c,core,c.group.data(),c.group.size());
+    c.open = false;
+  }
+  if(!c.open){
+    c.open = true;
+    c.wk = e.wk_id;
+    c.warp = e.warp_id;
+    c.inst = e.inst;
+    c.size = 0;
+    c.group.clear();
+  }
+  c.size++;
+
+  if(std::find(c.group.begin(),c.group.end(),line) == c.group.end())
+    c.group.push_back(line);
+}
+
+void WorkingSet::end_execution(){
+  for(unsigned int i=0;i<cores.size();i++){
+    if(cores[i].open){
+      push(cores[i],i,cores[i].group.data(),cores[i].group.size());
+      cores[i].open = false;
+    }
+  }
+}
+
+void WorkingSet::push(Core& c, unsigned int id, const unsigned long* lines, unsigned int n){
+  for(unsigned int i=0;i<n;i++){
+    c.lines.push_back(lines[i]);
+    c.counts[lines[i]]++;
+  }
+  c.units.push_back(n);
+
+  //Oldest unit leaves the window
+  if(c.units.size() > config.window){
+    for(unsigned int i=0;i<c.units.front();i++){
+      std::unordered_map<unsigned long,unsigned int>::iterator count = c.counts.find(c.lines.front());
+      if(--count->second == 0)
+        c.counts.erase(count);
+      c.lines.pop_front();
+    }
+    c.units.pop_front();
+  }
+
+  c.time++;
+  if(c.time % config.stride == 0)
+    out << execution << " " << id << " " << c.time << " " << c.counts.size() << "\n";
+}
+
+std::string WorkingSet::take(){
+  std::string samples = out.str();
+  out.str("");
+  return samples;
+}
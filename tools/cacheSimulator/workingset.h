@@ -0,0 +1,78 @@
+/*
+ * workingset.h
+ *
+ * Time series of the distinct cache lines touched over a sliding window of
+ * the accesses, or warp instructions, each core makes, showing when an
+ * execution's working set outgrows the cache.
+ */
+#ifndef WORKINGSET_H
+#define WORKINGSET_H
+
+#include <deque>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+
+
+struct WorkingSetConfig
+{
+   unsigned int window;      //Accesses or warp instructions in a window, 0 for none
+   unsigned int stride;      //Window positions between samples
+   bool warp;                //Window counts warp instructions rather than accesses
+};
+
+
+class WorkingSet
+{
+  public:
+    WorkingSet(const WorkingSetConfig& config, unsigned int line_size);
+
+    // Starts the series of execution n
+    void begin_execution(unsigned int n, unsigned int warp_size);
+
+    // Global memory access made on a core
+    void access(const Entry& e, unsigned int core);
+
+    // Closes the warp instructions still open
+    void end_execution();
+
+    // Samples written since the last call, lines of
+    // 'execution core time distinct lines'
+    std::string take();
+
+    // Drops any samples written so far
+    void clear(){ out.str("");}
+
+    bool enabled() const { return config.window != 0;}
+
+  private:
+    struct Core
+    {
+       Core():time(0),open(false){}
+
+       std::deque<unsigned long> lines;        //Lines of the units in the window, oldest first
+       std::deque<unsigned int> units;         //Lines each unit added
+       std::unordered_map<unsigned long,unsigned int> counts;   //Uses of each line in the window
+       unsigned long time;                     //Units seen
+
+       //Warp instruction being gathered
+       bool open;
+       unsigned int wk,warp,inst,size;
+       std::vector<unsigned long> group;
+    };
+
+    // Slides a core's window on by a unit touching the given lines
+    void push(Core& core, unsigned int id, const unsigned long* lines, unsigned int n);
+
+    WorkingSetConfig config;
+    unsigned int line_size;
+    unsigned int execution;
+    unsigned int warp_size;
+    std::vector<Core> cores;
+    std::ostringstream out;
+};
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * buffer_table.h
+ *
+ * Reads the side file the wrapper writes beside trace.txt, giving the device
+ * address range of every buffer passed to a kernel, for one execution after
+ * another:
+ *
+ *   argument index  address (hex)  size in bytes  name
+ *   ...
+ *   ---------------
+ *
+ * Trace addresses hold the low 32 bits of device pointers, so buffers are
+ * matched on those.
+ */
+#ifndef BUFFER_TABLE_H
+#define BUFFER_TABLE_H
+
+#include <stdio.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct BufferRange{
+  unsigned int arg;             //Kernel argument the buffer was passed as
+  unsigned long long address;   //First byte on the device
+  unsigned long long size;      //Bytes
+  std::string name;
+};
+
+typedef std::vector<BufferRange> BUFFER_VEC;
+
+class BufferTable
+{
+  public:
+    /*
+     * Reads the buffers of each execution from file. Returns false if it
+     * cannot be opened.
+     */
+    bool load(const char* file){
+      std::ifstream input(file);
+      if(!input.is_open())
+        return false;
+
+      std::string line;
+      BUFFER_VEC buffers;
+      while(std::getline(input,line)){
+        if(line.find("-") < line.length()){
+          executions.push_back(buffers);
+          buffers.clear();
+          continue;
+        }
+
+        BufferRange b;
+        char name[256];
+        int n = sscanf(line.c_str(),"%u %llx %llu %255s",&b.arg,&b.address,&b.size,name);
+        if(n < 3)
+          continue;
+        b.name = n == 4 ? name : "arg" + std::to_string(b.arg);
+        buffers.push_back(b);
+      }
+
+      //Last execution written without its terminator
+      if(!buffers.empty())
+        executions.push_back(buffers);
+      return true;
+    }
+
+    bool empty() const{ return executions.empty();}
+
+    /*
+     * Buffers of execution n, those of the last execution recorded for any
+     * beyond it
+     */
+    const BUFFER_VEC& execution(unsigned int n) const{
+      return executions.at(n < executions.size() ? n : executions.size() - 1);
+    }
+
+    /*
+     * Index of the buffer holding an address, or -1 if none does
+     */
+    static int find(const BUFFER_VEC& buffers, unsigned long long address){
+      for(unsigned int i=0;i<buffers.size();i++){
+        unsigned long long offset = (address - buffers[i].address) & 0xFFFFFFFFull;
+        if(offset < buffers[i].size)
+          return i;
+      }
+      return -1;
+    }
+
+  private:
+    std::vector<BUFFER_VEC> executions;
+};
+
+#endif
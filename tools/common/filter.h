@@ -0,0 +1,178 @@
+/*
+ * filter.h
+ *
+ * Selects the memory accesses of a trace a run is interested in, from an
+ * expression of comma separated clauses:
+ *
+ *   inst=n[-m]           instruction ids n to m
+ *   addr=lo-hi           byte addresses lo to hi, in hex
+ *   wk=n[-m]             workgroups n to m
+ *   op=r|w               reads or writes
+ *   loop=label[:n[-m]]   inside the loop labelled 'label', in iterations n to m
+ *
+ * An access is kept when it matches a clause of every field named in the
+ * expression, so 'inst=3,inst=7,op=r' keeps the reads of instructions 3 and 7.
+ */
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+/*
+ * Fields an expression selects on
+ */
+const int FILTER_INST = 0;
+const int FILTER_ADDR = 1;
+const int FILTER_WK   = 2;
+const int FILTER_OP   = 3;
+const int FILTER_LOOP = 4;
+const int FILTER_FIELDS = 5;
+
+/*
+ * Inclusive range of values, with the loop label for loop clauses
+ */
+struct FilterRange{
+  unsigned long long lo;
+  unsigned long long hi;
+  unsigned int label;
+};
+
+class AccessFilter
+{
+  public:
+    AccessFilter():active(false){}
+
+    /*
+     * Adds the clauses of an expression. Returns false if it is invalid.
+     */
+    bool parse(const std::string& expr){
+      size_t start = 0;
+      while(start <= expr.size()){
+        size_t end = expr.find(',',start);
+        if(end == std::string::npos)
+          end = expr.size();
+        if(end > start && !parse_clause(expr.substr(start,end - start)))
+          return false;
+        start = end + 1;
+      }
+      return active;
+    }
+
+    // Whether any clause was given
+    bool enabled() const{ return active;}
+
+    // Whether the expression selects on a field
+    bool uses(int field) const{ return !ranges[field].empty();}
+
+    /*
+     * Whether a value of a field passes, always true for fields the
+     * expression does not name. Reads are op 1 and writes op 0.
+     */
+    bool matches(int field, unsigned long long value) const{
+      const std::vector<FilterRange>& r = ranges[field];
+      if(r.empty())
+        return true;
+      for(unsigned int i=0;i<r.size();i++){
+        if(value >= r[i].lo && value <= r[i].hi)
+          return true;
+      }
+      return false;
+    }
+
+    /*
+     * Whether an access inside the given loops passes the loop clauses.
+     * A loop with iteration 0 is one the access is not inside.
+     */
+    bool matches_loops(const unsigned int* labels, const unsigned int* iterations, unsigned int n) const{
+      const std::vector<FilterRange>& r = ranges[FILTER_LOOP];
+      if(r.empty())
+        return true;
+      for(unsigned int i=0;i<r.size();i++){
+        for(unsigned int l=0;l<n;l++){
+          if(iterations[l] && labels[l] == r[i].label && iterations[l] >= r[i].lo && iterations[l] <= r[i].hi)
+            return true;
+        }
+      }
+      return false;
+    }
+
+  private:
+    bool parse_clause(const std::string& clause){
+      size_t eq = clause.find('=');
+      if(eq == std::string::npos)
+        return false;
+
+      std::string field = clause.substr(0,eq);
+      std::string value = clause.substr(eq + 1);
+      FilterRange range;
+      range.label = 0;
+
+      if(field == "inst"){
+        if(!parse_range(value,10,range))
+          return false;
+        ranges[FILTER_INST].push_back(range);
+      }
+      else if(field == "addr"){
+        if(!parse_range(value,16,range))
+          return false;
+        ranges[FILTER_ADDR].push_back(range);
+      }
+      else if(field == "wk"){
+        if(!parse_range(value,10,range))
+          return false;
+        ranges[FILTER_WK].push_back(range);
+      }
+      else if(field == "op"){
+        if(value != "r" && value != "w")
+          return false;
+        range.lo = range.hi = (value == "r");
+        ranges[FILTER_OP].push_back(range);
+      }
+      else if(field == "loop"){
+        size_t colon = value.find(':');
+        char* end;
+        range.label = strtoul(value.c_str(),&end,10);
+        if(end == value.c_str())
+          return false;
+
+        //Every iteration unless a range is given
+        range.lo = 1;
+        range.hi = ~0ull;
+        if(colon != std::string::npos && !parse_range(value.substr(colon + 1),10,range))
+          return false;
+        if(colon == std::string::npos && *end != '\0')
+          return false;
+        ranges[FILTER_LOOP].push_back(range);
+      }
+      else
+        return false;
+
+      active = true;
+      return true;
+    }
+
+    // Parses 'n' or 'n-m'
+    static bool parse_range(const std::string& text, int base, FilterRange& range){
+      const char* s = text.c_str();
+      char* end;
+      range.lo = strtoull(s,&end,base);
+      if(end == s)
+        return false;
+      range.hi = range.lo;
+
+      if(*end == '-'){
+        s = end + 1;
+        range.hi = strtoull(s,&end,base);
+        if(end == s)
+          return false;
+      }
+      return *end == '\0' && range.lo <= range.hi;
+    }
+
+    bool active;
+    std::vector<FilterRange> ranges[FILTER_FIELDS];
+};
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ * follow.h
+ *
+ * Reads a trace file line by line while another process may still be
+ * appending to it. At the end of the file the reader waits for more data,
+ * keeping any partial last line, and gives up once the file has not grown
+ * for a set time. Without following it behaves like std::getline.
+ */
+#ifndef FOLLOW_H
+#define FOLLOW_H
+
+#include <chrono>
+#include <istream>
+#include <string>
+#include <thread>
+
+const unsigned int FOLLOW_POLL_MS = 50;        //Time between checks for new data
+const unsigned int FOLLOW_IDLE_DEFAULT = 10;   //Seconds without growth before giving up
+
+class LineFollower
+{
+  public:
+    LineFollower(std::istream& input, bool follow = false, unsigned int idle_seconds = FOLLOW_IDLE_DEFAULT):
+      in(input),following(follow),idle_ms(idle_seconds * 1000){}
+
+    /*
+     * Reads the next complete line. Returns false at the end of the file,
+     * or when following, once the file stops growing.
+     */
+    bool getline(std::string& line){
+      unsigned int waited = 0;
+      std::string chunk;
+
+      while(true){
+        if(std::getline(in,chunk) && !in.eof()){
+          line = partial + chunk;
+          partial.clear();
+          return true;
+        }
+
+        //End of the data written so far, keep what there is of the line
+        if(!chunk.empty())
+          waited = 0;
+        partial += chunk;
+        in.clear();
+
+        if(!following || waited >= idle_ms){
+          //A last line without a newline still counts
+          if(partial.empty())
+            return false;
+          line.swap(partial);
+          partial.clear();
+          return true;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(FOLLOW_POLL_MS));
+        waited += FOLLOW_POLL_MS;
+      }
+    }
+
+  private:
+    std::istream& in;
+    bool following;
+    unsigned int idle_ms;
+    std::string partial;     //Start of a line whose end has not been written yet
+};
+
+#endif
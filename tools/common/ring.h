@@ -0,0 +1,96 @@
+/*
+ * ring.h
+ *
+ * Bounded ring of blocks passing records from one producer thread to one
+ * consumer thread. Records are gathered into blocks, so the threads only
+ * meet once per block, and a full ring holds up the producer until the
+ * consumer catches up. Blocks are swapped rather than copied and go round
+ * the ring again, so a pipeline runs in a fixed amount of memory.
+ */
+#ifndef RING_H
+#define RING_H
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+const unsigned int RING_BLOCKS = 8;             //Blocks in flight
+const unsigned int RING_BLOCK_SIZE = 1 << 16;   //Records in a block
+
+template<typename T>
+class RingBuffer
+{
+  public:
+    RingBuffer(unsigned int blocks = RING_BLOCKS, unsigned int block_size = RING_BLOCK_SIZE):
+      slots(blocks),head(0),count(0),closed(false),size(block_size){
+      filling.reserve(size);
+    }
+
+    // Appends a record, handing on its block once full
+    void push(const T& record){
+      filling.push_back(record);
+      if(filling.size() >= size)
+        flush();
+    }
+
+    // Hands on the records pushed so far, waiting for room in the ring
+    void flush(){
+      if(filling.empty())
+        return;
+
+      std::unique_lock<std::mutex> lock(mutex);
+      not_full.wait(lock,[this]{ return count < slots.size();});
+      slots[(head + count) % slots.size()].swap(filling);
+      ++count;
+      lock.unlock();
+      not_empty.notify_one();
+
+      //Reuses the block the consumer gave back
+      filling.clear();
+      filling.reserve(size);
+    }
+
+    // Flushes and ends the stream
+    void close(){
+      flush();
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+      not_empty.notify_one();
+    }
+
+    /*
+     * Swaps the next block of records into block, giving its old contents
+     * back to the ring. Returns false once the stream is closed and drained.
+     */
+    bool pop(std::vector<T>& block){
+      std::unique_lock<std::mutex> lock(mutex);
+      not_empty.wait(lock,[this]{ return count > 0 || closed;});
+      if(count == 0)
+        return false;
+
+      block.swap(slots[head]);
+      head = (head + 1) % slots.size();
+      --count;
+      lock.unlock();
+      not_full.notify_one();
+      return true;
+    }
+
+  private:
+    RingBuffer(const RingBuffer&);
+    RingBuffer& operator=(const RingBuffer&);
+
+    std::vector<std::vector<T> > slots;
+    unsigned int head;           //Oldest full block
+    unsigned int count;          //Full blocks
+    bool closed;
+
+    std::mutex mutex;
+    std::condition_variable not_full,not_empty;
+
+    //Block the producer is filling, touched by it alone
+    std::vector<T> filling;
+    unsigned int size;
+};
+
+#endif
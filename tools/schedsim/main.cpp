@@ -0,0 +1,294 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "execution.h"
+#include "parallel.h"
+#include "ring.h"
+#include "sim.h"
+
+/*
+  Schedules each kernel execution of a trace and simulates it, the
+  scheduled accesses passing straight from one stage to the other
+  through a ring buffer, with the two stages on threads of their own.
+  Nothing is written to or parsed back from cache.out.
+*/
+
+// Kinds of record passed from the scheduler to the simulator.
+const unsigned int RECORD_ACCESS = 0;
+const unsigned int RECORD_BEGIN = 1;   // Execution starts, warp_id holding the warp size
+                                       // and wk_id the number of workgroups
+const unsigned int RECORD_END = 2;
+
+struct Record{
+  unsigned int kind;
+  Entry entry;
+};
+
+Entry toEntry(const AccessRecord& access){
+  return Entry(access.address,access.op,access.workgroup,access.warp,access.inst);
+}
+
+
+void printUsage(const char* name){
+  std::cout << "Usage: " << name << " 'filename' 'algorithm' 'warp size' 'cache configuration' [options]\n";
+  std::cout << "algorithm options: 'none','rr','rand','seq','coalesced','gto','lrr','twolevel'\n";
+  std::cout << "cache configuration and options as for cacheSim, apart from -p and -follow, -seed\n";
+  std::cout << "also seeding random schedules and -replicas k giving each replica its own\n";
+  std::cout << "scheduler options: -threads n          schedule on up to n threads, one per core by default\n";
+  std::cout << "                   -filter clause,...  keep accesses matching inst=n[-m], addr=lo-hi,\n";
+  std::cout << "                                       wk=n[-m], op=r|w, loop=label[:n[-m]]\n";
+  std::cout << "                   -latency n          slots a warp stalls after a global load, 400 by default\n";
+  std::cout << "                   -active n           warps in the active pool of twolevel, 8 by default\n";
+}
+
+/*
+  Scheduling stage: parses and schedules one execution at a time,
+  pushing its accesses into the ring in schedule order.
+*/
+void scheduleExecutions(ExecutionReader& reader, const ScheduleConfig& config, RingBuffer<Record>& ring){
+
+  Record record;
+  unsigned int n = 0;
+  while(Trace* curr = reader.next()){
+
+    record.kind = RECORD_BEGIN;
+    record.entry = Entry(0,0,curr->getTotalWorkgroups(),curr->getWarpSize(),0);
+    ring.push(record);
+
+    record.kind = RECORD_ACCESS;
+    forEachScheduled(curr,config,[&](const Trace_entry& entry){
+      record.entry = toEntry(makeRecord(*curr,entry));
+      ring.push(record);
+    },n);
+
+    record.kind = RECORD_END;
+    ring.push(record);
+    delete curr;
+    n++;
+  }
+  ring.close();
+}
+
+/*
+  Simulation stage. With -all every access is simulated as it arrives,
+  otherwise an execution is gathered whole so its workgroups can be
+  sampled.
+*/
+void simulateExecutions(RingBuffer<Record>& ring, Simulator& sim, const Options& opts,
+                        std::ofstream& miss_out, std::ofstream& ws_out){
+
+  std::unique_ptr<Execution> exec;
+  std::vector<Record> block;
+  unsigned int n = 0;
+
+  while(ring.pop(block)){
+    for(std::vector<Record>::const_iterator r = block.begin(); r != block.end(); ++r){
+
+      if(r->kind == RECORD_ACCESS){
+        if(opts.all)
+          sim.access(r->entry);
+        else
+          exec->push(r->entry);
+      }
+      else if(r->kind == RECORD_BEGIN){
+        if(opts.all)
+          sim.begin_execution(r->entry.warp_id,r->entry.wk_id,n);
+        else
+          exec.reset(new Execution(r->entry.warp_id,r->entry.wk_id));
+      }
+      else{
+        std::cout <<"\nExecuting Trace " << n <<std::endl;
+        if(opts.all)
+          sim.end_execution();
+        else
+          sim.run(*exec,n);
+        sim.print_tlb(std::cout);
+
+        miss_out << sim.take_misses();
+        ws_out << sim.take_working_set();
+        n++;
+      }
+    }
+  }
+}
+
+/*
+  Replica stage. Each execution is parsed once and scheduled for every
+  replica concurrently, on a copy of the trace, each replica's schedule
+  being fed to a simulator of its own. Random schedules and workgroup
+  samples are drawn from each replica's own streams, so the spread of
+  the results over the replicas is reported.
+*/
+std::vector<Report> simulateReplicas(ExecutionReader& reader, const ScheduleConfig& schedConfig,
+                                     const CacheConfig& config, const Options& opts,
+                                     std::ofstream& miss_out, std::ofstream& ws_out){
+
+  std::vector<std::unique_ptr<Simulator> > sims;
+  for(unsigned int r = 0; r < opts.replicas; r++)
+    sims.push_back(std::unique_ptr<Simulator>(new Simulator(config,opts,r)));
+
+  // Threads are shared out between the replicas
+  ScheduleConfig inner = schedConfig;
+  inner.threads = std::max(1u,schedConfig.threads / opts.replicas);
+
+  unsigned int n = 0;
+  while(Trace* curr = reader.next()){
+    std::cout <<"\nExecuting Trace " << n <<std::endl;
+
+    parallelFor(opts.replicas,schedConfig.threads,[&](unsigned int r){
+      Trace copy(*curr);
+      Simulator& sim = *sims[r];
+
+      if(opts.all){
+        sim.begin_execution(copy.getWarpSize(),copy.getTotalWorkgroups(),n);
+        forEachScheduled(&copy,inner,[&](const Trace_entry& entry){
+          sim.access(toEntry(makeRecord(copy,entry)));
+        },n,r);
+        sim.end_execution();
+      }
+      else{
+        Execution exec(copy.getWarpSize(),copy.getTotalWorkgroups());
+        forEachScheduled(&copy,inner,[&](const Trace_entry& entry){
+          exec.push(toEntry(makeRecord(copy,entry)));
+        },n,r);
+        sim.run(exec,n);
+      }
+    });
+
+    //Miss stream and working set of the first replica only
+    miss_out << sims[0]->take_misses();
+    ws_out << sims[0]->take_working_set();
+    for(unsigned int r = 1; r < opts.replicas; r++){
+      sims[r]->take_misses();
+      sims[r]->take_working_set();
+    }
+
+    delete curr;
+    n++;
+  }
+
+  std::vector<Report> results;
+  for(unsigned int r = 0; r < opts.replicas; r++)
+    results.push_back(sims[r]->report());
+  return results;
+}
+
+int main(int argc, char *argv[]){
+
+  if(argc < 9){
+    printUsage(argv[0]);
+    return 0;
+  }
+
+  ScheduleConfig schedConfig;
+  if(!setAlgorithm(argv[2],argv[3],schedConfig) || !isdigit(argv[3][0])){
+    std::cout <<"Algorithm not supported\n";
+    printUsage(argv[0]);
+    return 0;
+  }
+  schedConfig.warpSize = atoi(argv[3]);
+
+  // Scheduler options are taken out before the cache simulator's are parsed
+  std::vector<char*> args(argv,argv + 4);
+  for(int i = 4; i < argc; i++){
+    if(!strcmp(argv[i],"-threads") && i+1 < argc){
+      schedConfig.threads = std::max(1,atoi(argv[++i]));
+    }
+    else if(!strcmp(argv[i],"-latency") && i+1 < argc){
+      schedConfig.issue.latency = atoi(argv[++i]);
+    }
+    else if(!strcmp(argv[i],"-active") && i+1 < argc){
+      schedConfig.issue.active = std::max(1,atoi(argv[++i]));
+    }
+    else if(!strcmp(argv[i],"-filter") && i+1 < argc){
+      if(!schedConfig.filter.parse(argv[++i])){
+        std::cout << "Invalid filter "<< argv[i] <<"\n";
+        return 0;
+      }
+    }
+    else{
+      args.push_back(argv[i]);
+    }
+  }
+
+  CacheConfig config;
+  Options opts;
+  if(parse_config(args.size(),args.data(),4,config,opts) == -1)
+    return 0;
+
+  if(opts.threads > 0 || opts.follow){
+    std::cout << "-p and -follow need the cacheSim tool\n";
+    return 0;
+  }
+  schedConfig.seed = opts.seed;
+
+  ExecutionReader reader(schedConfig);
+  if(!reader.open(argv[1])){
+    std::cout << "unable to open file "<< argv[1] <<std::endl;
+    return 0;
+  }
+
+  //Prints cache configuration information to stdout
+  print_config(config.num_lines * config.line_size,config.line_size,config.associativity,
+               config.num_lines / config.associativity);
+  std::cout << "Seed: "<< opts.seed << std::endl;
+
+  //Optional outputs for the miss stream and working set series
+  std::ofstream miss_out, ws_out;
+  if(!opts.miss_file.empty()){
+    miss_out.open(opts.miss_file.c_str());
+    if(!miss_out.is_open()){
+      std::cout << "unable to open file "<< opts.miss_file <<std::endl;
+      return 0;
+    }
+  }
+  if(!opts.ws_file.empty()){
+    ws_out.open(opts.ws_file.c_str());
+    if(!ws_out.is_open()){
+      std::cout << "unable to open file "<< opts.ws_file <<std::endl;
+      return 0;
+    }
+  }
+
+  if(opts.replicas > 1){
+    std::vector<Report> results = simulateReplicas(reader,schedConfig,config,opts,miss_out,ws_out);
+
+    //Prints the spread of cache performance over the replicas
+    print_replicas(std::cout,results,opts);
+    return 0;
+  }
+
+  Simulator sim(config,opts);
+  RingBuffer<Record> ring;
+
+  std::thread scheduler(scheduleExecutions,std::ref(reader),std::cref(schedConfig),std::ref(ring));
+  simulateExecutions(ring,sim,opts,miss_out,ws_out);
+  scheduler.join();
+
+  //Prints cache performance data to stdout
+  sim.report().print(std::cout,opts);
+  return 0;
+}
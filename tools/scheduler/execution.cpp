@@ -0,0 +1,292 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+#include <cctype>
+#include <ctime>
+#include <thread>
+#include "execution.h"
+#include "merge.h"
+#include "parse.h"
+#include "schedule.h"
+#include "warp.h"
+
+/*
+  Defaults to warps of 32 threads, and scheduling with one thread
+  per hardware thread.
+*/
+ScheduleConfig::ScheduleConfig():warpSize(32),follow(false),followIdle(FOLLOW_IDLE_DEFAULT),
+    threads(std::max(1u,std::thread::hardware_concurrency())),seed(time(NULL)){}
+
+AccessRecord makeRecord(const Trace& trace, const Trace_entry& entry){
+  AccessRecord record;
+  record.address = entry.getMemAddr();
+  record.op = entry.getRead() | (entry.getLocalMem() << 1) | (entry.getReadOnly() << 2);
+  record.workgroup = getWorkgroupId(trace,entry);
+  record.warp = getWarpId(trace,entry);
+  record.inst = entry.getName();
+  return record;
+}
+
+bool setAlgorithm(const char* name, const char* warp, ScheduleConfig& config){
+
+  if(!strcmp(name,"rr")){             // Round Robin scheduling
+     Trace::algorithm = Trace::RR;
+  }
+  else if(!strcmp(name,"seq")){       // Sequential Scheduling
+    Trace::algorithm = Trace::SEQUENTIAL;
+  }
+  else if(!strcmp(name,"rand")){      // Random scheduling
+     Trace::algorithm = Trace::RANDOM;
+  }
+  else if(!strcmp(name,"coalesced")){ // Coalesced scheduling
+    Trace::algorithm = Trace::COALESCED;
+  }
+  else if(!strcmp(name,"gto")){       // Greedy then oldest warp scheduling
+    Trace::algorithm = Trace::GTO;
+  }
+  else if(!strcmp(name,"lrr")){       // Loose round robin warp scheduling
+    Trace::algorithm = Trace::LRR;
+  }
+  else if(!strcmp(name,"twolevel")){  // Two-level warp scheduling
+    Trace::algorithm = Trace::TWO_LEVEL;
+  }
+  else if(!strcmp(name,"none")){       // No scheduling
+    Trace::algorithm = Trace::NONE;    
+  }
+  else{
+    return false;
+  }
+
+  bool warps = Trace::algorithm == Trace::COALESCED || Trace::algorithm == Trace::GTO ||
+               Trace::algorithm == Trace::LRR || Trace::algorithm == Trace::TWO_LEVEL;
+  if(warps && warp && isdigit(warp[0])){
+    config.warpSize = atoi(warp);
+  }
+  return true;
+}
+
+/*
+  Every trace entry is given an index specifying to number of 
+  entries the thread has made before.
+*/
+static void setIndices(Trace& trace){
+ // Number of accesses made by each thread
+ std::vector<int>num_accesses(trace.getTotalThreads(),0);
+ 
+ for( std::vector<Trace_entry>::iterator iter = trace.entries.begin(), \
+        end = trace.entries.end();iter!=end;++iter)
+    {
+        unsigned int tVal = iter->getThreadVal(trace);
+        iter->setIndex(num_accesses[tVal]++);
+    }
+
+}
+
+
+/*
+  Drops the accesses outside the workgroups selected by the filter,
+  once the size of the thread space is known.
+*/
+static void filterWorkgroups(Trace& trace, const AccessFilter& filter){
+  std::vector<Trace_entry>::iterator last = std::remove_if(trace.entries.begin(),trace.entries.end(),
+    [&trace,&filter](const Trace_entry& entry){
+      return !entry.getBarrier() && !filter.matches(FILTER_WK,getWorkgroupId(trace,entry));
+    });
+  trace.entries.erase(last,trace.entries.end());
+}
+
+
+ExecutionReader::ExecutionReader(const ScheduleConfig& c):config(c),useMap(false),pos(NULL){}
+
+bool ExecutionReader::open(const char* path){
+
+  input.open(path);
+  if(!input.is_open())
+    return false;
+
+  // Pipes and files still being written cannot be mapped
+  useMap = !config.follow && mapped.open(path);
+  pos = mapped.begin();
+  lines.reset(new LineFollower(input,config.follow,config.followIdle));
+  return true;
+}
+
+Trace* ExecutionReader::next(){
+  return useMap ? parseMapped() : parseLines();
+}
+
+/*
+ First line of the input trace file provides metadata on the trace 
+ regarding workgroup size in the form 'local size: x y z'. Where
+ x, y, & z are the number of threads in the workgroup in three
+ dimensions.
+
+ If a the dimension does not exist in the thread space it's value is zero.
+ This is used to record the number of dimensions in the trace.
+*/
+void ExecutionReader::setThreadDim(Trace* trace, const std::string& localSize){
+
+  unsigned int local_dim[3];
+  sscanf (localSize.c_str(),"local size:%d %d %d",&local_dim[0],&local_dim[1],&local_dim[2]);
+ 
+  // Count number of dimensions
+  unsigned short dim_count = 0;
+  for(unsigned int i = 0; i< maxDim; i++){
+    if(local_dim[i] > 0){
+       ++dim_count;
+    }
+    else {local_dim[i] = 1;}
+  }
+
+  trace->setDim(dim_count);
+  trace->setLocalSize(local_dim[0],local_dim[1],local_dim[2]);
+
+  /* 
+    Checks that the number of threads in a warp is less than the number of 
+    threads in a workgroup, since warps cannot span workgroups.
+  */
+  unsigned int workgroupSize = local_dim[0] * local_dim[1]* local_dim[2];
+  if(workgroupSize < config.warpSize){
+      trace->setWarpSize(workgroupSize);
+  }
+  else {
+      trace->setWarpSize(config.warpSize);
+  }
+
+}
+
+/*
+  Completes an execution once all its lines have been parsed.
+*/
+void ExecutionReader::finishExecution(Trace& trace){
+
+  if(trace.getGlobal(1) == 0) 
+    trace.setGlobalSize(1,1); 
+  
+  if(trace.getGlobal(2) == 0) 
+    trace.setGlobalSize(2,1);
+
+
+  if(config.filter.uses(FILTER_WK))
+    filterWorkgroups(trace,config.filter);
+
+  // Give each access an index in the order of it's thread's accesses,
+  // filtered accesses having been indexed as they were parsed
+  if(!config.filter.enabled())
+    setIndices(trace);
+}
+
+/*
+  Reads and parses the next execution in the input, line by line,
+  where a line is a trace entry. The execution is returned once its
+  terminating line has been read, or NULL at the end of the input.
+*/
+Trace* ExecutionReader::parseLines(){
+
+  std::string line;
+  if(!lines || !lines->getline(line) || line.find("local size") == std::string::npos)
+    return NULL;
+
+  Trace* curr = new Trace(); 
+  ThreadCounts counts;
+  
+  // Sets the workgroup size based on first line of the execution
+  setThreadDim(curr,line);
+
+  while(lines->getline(line)){
+
+    bool end =  parseInput(line,*curr,config.filter,counts);
+    if(end){
+      finishExecution(*curr);
+      return curr;
+    }
+  } 
+
+  // Input ended part way through the execution
+  delete curr;
+  return NULL;
+}
+
+/*
+  Parses the next execution of the mapped input, moving past it. Its
+  lines are found by scanning for the terminator, then parsed in chunks
+  on several threads. Returns NULL at the end of the input.
+*/
+Trace* ExecutionReader::parseMapped(){
+
+  const char* end = mapped.end();
+  if(pos >= end)
+    return NULL;
+
+  const char* newline = (const char*)memchr(pos,'\n',end - pos);
+  if(!newline)
+    return NULL;
+
+  std::string header(pos,newline);
+  if(header.find("local size") == std::string::npos)
+    return NULL;
+
+  // Consecutive hypens indicate end of the trace.
+  const char* first = newline + 1;
+  const char* hyphen = (const char*)memchr(first,'-',end - first);
+  if(!hyphen)
+    return NULL;         // Input ended part way through the execution
+
+  const char* last = hyphen;
+  while(last > first && last[-1] != '\n')
+    --last;
+
+  Trace* curr = new Trace(); 
+
+  // Sets the workgroup size based on first line of the execution
+  setThreadDim(curr,header);
+
+  parseRecords(first,last,*curr,config.filter,config.threads);
+  finishExecution(*curr);
+
+  newline = (const char*)memchr(hyphen,'\n',end - hyphen);
+  pos = newline ? newline + 1 : end;
+  return curr;
+}
+
+void forEachScheduled(Trace* trace, const ScheduleConfig& config,
+                      const std::function<void(const Trace_entry&)>& emit,
+                      unsigned int execution, unsigned int replica){
+
+  if(mergeable()){
+    mergeSchedule(*trace,emit);
+    return;
+  }
+
+  // Schedule trace according to specified algorithm.
+  if(Trace::algorithm != Trace::NONE){
+    schedule(trace,config.threads,scheduleSeed(config.seed,replica,execution),config.issue);
+  }
+
+  for( std::vector<Trace_entry>::const_iterator iter = trace->entries.begin(), \
+       end = trace->entries.end();iter!=end;++iter)
+  {
+       if(iter->getBarrier())     //Don't print barriers
+           continue;
+       emit(*iter);
+  }
+}
@@ -0,0 +1,95 @@
+#ifndef EXECUTION_H
+#define EXECUTION_H
+
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include "filter.h"
+#include "follow.h"
+#include "issue.h"
+#include "mapped.h"
+#include "trace.h"
+
+/*
+  Settings for reading executions from a trace file and scheduling
+  them, shared by the scheduler and the tools built on its library.
+*/
+struct ScheduleConfig{
+  ScheduleConfig();
+
+  unsigned int warpSize;    // Threads in a warp, capped at the workgroup size
+  bool follow;              // Read the input while it is still being written
+  unsigned int followIdle;  // Seconds it may stop growing before reading ends
+  AccessFilter filter;      // Accesses kept, barriers always being kept
+  unsigned int threads;     // Threads parsing and scheduling each execution
+  unsigned long long seed;  // Seeds random schedules, the clock by default
+  IssueModel issue;         // Issue model of the warp scheduling policies
+};
+
+/*
+  An access as the cache simulator reads it. Bit 0 of op is set for
+  reads, bit 1 for accesses to local memory and bit 2 for loads of
+  read-only data.
+*/
+struct AccessRecord{
+  unsigned int address;
+  unsigned int op;
+  unsigned int workgroup;
+  unsigned int warp;
+  unsigned int inst;
+};
+
+AccessRecord makeRecord(const Trace& trace, const Trace_entry& entry);
+
+// Sets Trace::algorithm from its name, and the warp size of coalesced
+// scheduling and the warp scheduling policies if 'warp' is a number.
+// False if the name is unknown.
+bool setAlgorithm(const char* name, const char* warp, ScheduleConfig& config);
+
+/*
+  Reads the executions of a trace file one at a time. A finished file
+  is mapped and parsed in place, one still being written read line by
+  line.
+*/
+class ExecutionReader{
+ public:
+  ExecutionReader(const ScheduleConfig& config);
+
+  // False if the file cannot be opened
+  bool open(const char* path);
+
+  // Next parsed execution, owned by the caller, or NULL at the end of the
+  // input. Nothing is printed, callers report the execution if they wish.
+  Trace* next();
+
+ private:
+  ExecutionReader(const ExecutionReader&);
+  ExecutionReader& operator=(const ExecutionReader&);
+
+  Trace* parseLines();
+  Trace* parseMapped();
+
+  // Sets the thread space of an execution from its header line
+  void setThreadDim(Trace* trace, const std::string& localSize);
+  void finishExecution(Trace& trace);
+
+  const ScheduleConfig& config;
+  std::ifstream input;
+  std::unique_ptr<LineFollower> lines;
+  MappedFile mapped;
+  bool useMap;
+  const char* pos;
+};
+
+/*
+  Calls emit with each access of the trace in schedule order, without
+  barriers. The rr and seq schedules are merged from the threads'
+  streams as they are written, the others sorted first. A random
+  schedule is fixed by the seed, the execution and the replica.
+*/
+void forEachScheduled(Trace* trace, const ScheduleConfig& config,
+                      const std::function<void(const Trace_entry&)>& emit,
+                      unsigned int execution = 0, unsigned int replica = 0);
+
+#endif //EXECUTION_H
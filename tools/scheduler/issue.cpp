@@ -0,0 +1,169 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <set>
+#include "issue.h"
+#include "warp.h"
+
+/*
+  A warp instruction, a run of the coalesced schedule made by one warp
+  in the same loop iterations and instruction.
+*/
+struct WarpInst{
+  size_t first,last;   // Entries of the run
+  bool load;           // Whether it reads global memory, stalling the warp
+};
+
+// Warp instructions of a warp, in program order.
+struct WarpStream{
+  WarpStream():next(0){}
+
+  std::vector<unsigned int> insts;
+  unsigned int next;   // Next to issue
+};
+
+static bool sameLoops(const Loop_timestamp& a, const Loop_timestamp& b){
+  if(a.depth != b.depth)
+    return false;
+  for(unsigned int i = 0; i < a.depth; i++){
+    if(a.labels[i] != b.labels[i] || a.iterations[i] != b.iterations[i])
+      return false;
+  }
+  return true;
+}
+
+/*
+  The coalesced schedule already orders each warp's instructions as in
+  the program, so scheduling policies only decide which warp issues
+  next. Warps are aged by workgroup, then by position in the workgroup,
+  the oldest being the first launched.
+
+  Round robin rotates over the ready warps from the one after the last
+  to issue. Greedy then oldest keeps issuing from the same warp until
+  it stalls or finishes, then takes the oldest ready warp. Two-level
+  rotates over a small active pool of warps, demoting a warp which
+  stalls to the pending warps, and filling the pool with the oldest
+  pending warps which are ready.
+*/
+void issueOrder(const Trace& t, std::vector<Trace_entry>& entries, const IssueModel& model){
+
+  if(entries.empty())
+    return;
+
+  // Split the schedule into warp instructions, and age their warps
+  std::vector<WarpInst> insts;
+  std::vector<unsigned long long> owner;
+  for(size_t i = 0; i < entries.size(); i++){
+    const Trace_entry& e = entries[i];
+    unsigned int warp = getWarpId(t,e);
+
+    if(i == 0 || warp != getWarpId(t,entries[i - 1]) || e.getName() != entries[i - 1].getName() ||
+       !sameLoops(e.getLoops(),entries[i - 1].getLoops())){
+      WarpInst inst = {i,i,false};
+      insts.push_back(inst);
+      owner.push_back(((unsigned long long)getWorkgroupId(t,e) << 32) | (warp / t.getTotalWorkgroups()));
+    }
+
+    insts.back().last = i + 1;
+    insts.back().load |= e.getRead() && !e.getLocalMem();
+  }
+
+  std::vector<unsigned long long> ages(owner);
+  std::sort(ages.begin(),ages.end());
+  ages.erase(std::unique(ages.begin(),ages.end()),ages.end());
+
+  std::vector<WarpStream> warps(ages.size());
+  for(unsigned int i = 0; i < insts.size(); i++){
+    unsigned int w = std::lower_bound(ages.begin(),ages.end(),owner[i]) - ages.begin();
+    warps[w].insts.push_back(i);
+  }
+
+  // Warps able to issue, by age, the active pool of two-level scheduling,
+  // and stalled warps by the slot they wake at
+  std::set<unsigned int> ready,active;
+  typedef std::pair<unsigned long,unsigned int> Wake;
+  std::priority_queue<Wake,std::vector<Wake>,std::greater<Wake> > stalled;
+
+  for(unsigned int w = 0; w < warps.size(); w++)
+    ready.insert(w);
+
+  bool twoLevel = Trace::algorithm == Trace::TWO_LEVEL;
+  std::set<unsigned int>& pool = twoLevel ? active : ready;
+
+  std::vector<unsigned int> order;
+  order.reserve(insts.size());
+  unsigned long slot = 0;
+  unsigned int current = warps.size();   // Warp which issued last
+
+  while(order.size() < insts.size()){
+
+    while(!stalled.empty() && stalled.top().first <= slot){
+      ready.insert(stalled.top().second);
+      stalled.pop();
+    }
+
+    while(twoLevel && active.size() < model.active && !ready.empty()){
+      active.insert(*ready.begin());
+      ready.erase(ready.begin());
+    }
+
+    // Every warp is stalled, skip to the first to wake up
+    if(pool.empty()){
+      slot = stalled.top().first;
+      continue;
+    }
+
+    unsigned int w;
+    if(Trace::algorithm == Trace::GTO){
+      w = pool.count(current) ? current : *pool.begin();
+    }
+    else{
+      std::set<unsigned int>::iterator next = pool.upper_bound(current);
+      w = next == pool.end() ? *pool.begin() : *next;
+    }
+
+    WarpStream& warp = warps[w];
+    unsigned int i = warp.insts[warp.next++];
+    order.push_back(i);
+    ++slot;
+    current = w;
+
+    if(warp.next == warp.insts.size()){
+      pool.erase(w);
+    }
+    else if(insts[i].load){
+      pool.erase(w);
+      stalled.push(Wake(slot + model.latency,w));
+    }
+  }
+
+  std::vector<Trace_entry> issued;
+  issued.reserve(entries.size());
+  for(size_t n = 0; n < order.size(); n++){
+    const WarpInst& inst = insts[order[n]];
+    issued.insert(issued.end(),entries.begin() + inst.first,entries.begin() + inst.last);
+  }
+  entries.swap(issued);
+}
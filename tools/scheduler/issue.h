@@ -0,0 +1,26 @@
+#ifndef ISSUE_H
+#define ISSUE_H
+
+#include <vector>
+#include "trace.h"
+
+/*
+  Issue model of the warp scheduling policies. One warp instruction
+  issues per slot, and a warp loading from global memory waits
+  'latency' slots before it can issue again. Two-level scheduling
+  picks from a pool of 'active' warps.
+*/
+struct IssueModel{
+  IssueModel():latency(400),active(8){}
+
+  unsigned int latency;   // About the DRAM latency of a GTX 480, in cycles
+  unsigned int active;    // Warps in the active pool of two-level scheduling
+};
+
+/*
+  Reorders entries already in coalesced order into the order the warp
+  scheduling policy of Trace::algorithm issues their warp instructions.
+*/
+void issueOrder(const Trace& t, std::vector<Trace_entry>& entries, const IssueModel& model);
+
+#endif //ISSUE_H
@@ -19,23 +19,44 @@ You should have received a copy of the GNU General Public License
 along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
 */
 
+#include <cctype>
 #include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include "buffer_table.h"
+#include "execution.h"
+#include "parallel.h"
 #include "trace.h"
-#include "parse.h"
-#include "schedule.h"
 #include "warp.h"
 
 /*
+ Reading and scheduling settings. With '-follow [seconds]' the input
+ is read while it is still being written, each execution being
+ scheduled and written out as soon as its terminating line arrives.
+ With '-filter clause,...' only the accesses matching the expression,
+ see filter.h, are kept. With '-threads n' scheduling uses up to n
+ threads, by default one per hardware thread.
+*/
+ScheduleConfig argConfig;
 
- Uses a command line argument to set the scheduling algorithm. 
- Recorded in the Trace object.
-
- If no warp size is specified for coalesced scheduling, default
- to 32 threads.
+/*
+ With '-replicas n' random scheduling makes n schedules of each
+ execution from the one parse, on up to '-threads' threads, writing
+ schedule r to cache.out.r. Each is fixed by '-seed n', so runs can
+ be repeated.
+*/
+unsigned int argReplicas = 1;
 
+/*
+ With '-buffers file' the accesses of each execution are attributed to
+ the buffers whose device address ranges the wrapper recorded.
 */
+BufferTable argBuffers;
+bool useBuffers = false;
 
-unsigned int argWarpSize = 32;
+// Segment of memory a warp's accesses are coalesced into.
+const unsigned int segmentSize = 128;
 
 // File used for plotting memory accesses using R.
 std::ofstream graph("graph.out",std::ofstream::out);
@@ -45,27 +66,53 @@ std::ofstream cache("cache.out",std::ofstream::out);
 
   
 
+/*
+
+ Uses a command line argument to set the scheduling algorithm. 
+ Recorded in the Trace object.
+
+ If no warp size is specified for coalesced scheduling, default
+ to 32 threads.
+
+*/
 void assignAlgorithm ( char* argv[], int argc) {
 
-  if(!strcmp(argv[2],"rr")){             // Round Robin scheduling
-     Trace::algorithm = Trace::RR;
-  }
-  else if(!strcmp(argv[2],"seq")){       // Sequential Scheduling
-    Trace::algorithm = Trace::SEQUENTIAL;
-  }
-  else if(!strcmp(argv[2],"rand")){      // Random scheduling
-     Trace::algorithm = Trace::RANDOM;
-  }
-  else if(!strcmp(argv[2],"coalesced")){ // Coalesced scheduling
+  setAlgorithm(argv[2],argc >= 4 ? argv[3] : NULL,argConfig);
 
-    if(argc >= 4){
-      argWarpSize = atoi(argv[3]);
-    
+  for(int i = 3; i < argc; i++){
+    if(!strcmp(argv[i],"-follow")){
+      argConfig.follow = true;
+      if(i+1 < argc && isdigit(argv[i+1][0]))
+        argConfig.followIdle = atoi(argv[++i]);
+    }
+    else if(!strcmp(argv[i],"-buffers") && i+1 < argc){
+      if(!argBuffers.load(argv[++i])){
+        std::cout << "unable to open file "<< argv[i] <<std::endl;
+        std::exit(0);
+      }
+      useBuffers = !argBuffers.empty();
+    }
+    else if(!strcmp(argv[i],"-threads") && i+1 < argc){
+      argConfig.threads = std::max(1,atoi(argv[++i]));
+    }
+    else if(!strcmp(argv[i],"-seed") && i+1 < argc){
+      argConfig.seed = strtoull(argv[++i],NULL,10);
+    }
+    else if(!strcmp(argv[i],"-replicas") && i+1 < argc){
+      argReplicas = std::max(1,atoi(argv[++i]));
+    }
+    else if(!strcmp(argv[i],"-latency") && i+1 < argc){
+      argConfig.issue.latency = atoi(argv[++i]);
+    }
+    else if(!strcmp(argv[i],"-active") && i+1 < argc){
+      argConfig.issue.active = std::max(1,atoi(argv[++i]));
+    }
+    else if(!strcmp(argv[i],"-filter") && i+1 < argc){
+      if(!argConfig.filter.parse(argv[++i])){
+        std::cout << "Invalid filter "<< argv[i] <<"\n";
+        std::exit(0);
+      }
     }
-    Trace::algorithm = Trace::COALESCED;
-  }
-  else if(!strcmp(argv[2],"none")){       // No scheduling
-    Trace::algorithm = Trace::NONE;    
   }
 }
 
@@ -79,16 +126,24 @@ void validateArguments(int argc, char *argv[]){
   // Check number of arguments.
   if(argc < 3){
     std::cout << "Usage: " << argv[0] << " 'filename' 'algorithm'\n";
-    std::cout << "algorithm options: 'none','rr','rand','seq','coalesced' 'warp size'\n";
+    std::cout << "algorithm options: 'none','rr','rand','seq','coalesced' 'warp size',\n";
+    std::cout << "                   'gto','lrr','twolevel' 'warp size'\n";
+    std::cout << "options: -follow [seconds]  process executions as they are appended\n";
+    std::cout << "         -filter clause,...  keep accesses matching inst=n[-m], addr=lo-hi,\n";
+    std::cout << "                             wk=n[-m], op=r|w, loop=label[:n[-m]]\n";
+    std::cout << "         -buffers file       report accesses of each buffer in the wrapper's buffers.txt\n";
+    std::cout << "         -threads n          schedule on up to n threads, one per core by default\n";
+    std::cout << "         -seed n             seed random schedules, the clock by default\n";
+    std::cout << "         -replicas n         make n random schedules, written to cache.out.0 onwards\n";
+    std::cout << "         -latency n          slots a warp stalls after a global load, gto, lrr and\n";
+    std::cout << "                             twolevel, 400 by default\n";
+    std::cout << "         -active n           warps in the active pool of twolevel, 8 by default\n";
     std::exit(0);
   }
 
   // Check valid algorithm option given
-  int valid_alg = strcmp(argv[2],"none");
-  valid_alg = valid_alg && strcmp(argv[2],"rr") && strcmp(argv[2],"seq");
-  valid_alg = valid_alg && strcmp(argv[2],"coalesced") && strcmp(argv[2],"rand"); 
-
-  if(valid_alg){
+  ScheduleConfig config;
+  if(!setAlgorithm(argv[2],NULL,config)){
     std::cout <<"Algorithm not supported\n";
     std::exit(0);
   }
@@ -97,147 +152,172 @@ void validateArguments(int argc, char *argv[]){
 
 /* 
 
-   Prints reordered trace to files for graphing and cache simulation.
+   Prints an access of the reordered trace to files for graphing and
+   cache simulation.
 
 */
-void writeOutput(const Trace* trace){
-
-
-  /*
-    Cache simulation needs to know the number of threads in a warp and
-    total number of workgroups. This is provided as the first line
-    of the input file.
-  */
-  cache <<trace->getWarpSize() << " "<<trace->getTotalWorkgroups()<<std::endl;
-
-  for( std::list<Trace_entry>::const_iterator iter = trace->entries.begin(), \
-       end = trace->entries.end();iter!=end;++iter)
-  {
- 
-
-       if(!iter->getBarrier()){   //Don't print barriers
-
-           graph << std::hex <<iter->getMemAddr()<<std::dec << " "\
-                 << iter->getRead() << " "\
-                 << iter->getThreadId(0) << " " \
-                 << iter->getThreadId(1) << " " \
-                 << iter->getThreadId(2) << std::endl;     
-
-           cache << std::hex <<iter->getMemAddr()<<std::dec << " "\
-                 << iter->getRead() << " "\
-                 << getWorkgroupId(*iter)  << " " \
-                 << getWarpId(*iter) << " " \
-                 << iter->getName() << std::endl;            }
-  }
-
-  cache << "------------------------"<<std::endl;
-
-  
+void writeEntry(const Trace& trace, const Trace_entry& entry, std::ostream& cache, std::ostream* graph){
+
+       /*
+         The graph only shows global memory. Lines are not flushed one
+         by one, the files being flushed once per execution.
+       */
+       AccessRecord record = makeRecord(trace,entry);
+
+       if(graph && !entry.getLocalMem()){
+           *graph << std::hex <<entry.getMemAddr()<<std::dec << " "\
+                 << entry.getRead() << " "\
+                 << entry.getThreadId(0) << " " \
+                 << entry.getThreadId(1) << " " \
+                 << entry.getThreadId(2) << "\n";     
+       }
+
+       cache << std::hex <<record.address<<std::dec << " "\
+             << record.op << " "\
+             << record.workgroup  << " " \
+             << record.warp << " " \
+             << record.inst << "\n";
 }
 
 /*
-  Every trace entry is given an index specifying to number of 
-  entries the thread has made before.
+  Global memory reads and writes of each buffer in the scheduled trace,
+  the requests left once the accesses of each warp instruction are
+  coalesced into segments, and the bytes of the segments touched.
+  Misses need a cache, so are left to cacheSim.
 */
-void setIndices(Trace& trace){
- std::cout << trace<<std::endl;
- // Number of accesses made by each thread
- std::vector<int>num_accesses(trace.getTotalThreads(),0);
- 
- for( std::list<Trace_entry>::iterator iter = trace.entries.begin(), \
-        end = trace.entries.end();iter!=end;++iter)
-    {
-        unsigned int tVal = iter->getThreadVal(trace);
-        //std::cout <<*iter<<tVal<<" "<<trace.getTotalThreads() <<std::endl;
-
-        iter->setIndex(num_accesses[tVal]++);
+class BufferCounts{
+ public:
+  BufferCounts(const BUFFER_VEC& b):buffers(b),slots(b.size() + 1),
+      reads(slots,0),writes(slots,0),requests(slots,0),segments(slots){
+    group[0] = group[1] = group[2] = ~0u;
+  }
 
-    }
+  // Counts the next access of the schedule
+  void add(const Trace& trace, const Trace_entry& entry){
+    if(entry.getLocalMem())
+      return;
 
-}
+    // Last slot for accesses outside every buffer
+    int found = BufferTable::find(buffers,entry.getMemAddr());
+    unsigned int b = found == -1 ? buffers.size() : found;
 
+    if(entry.getRead())
+      ++reads[b];
+    else
+      ++writes[b];
 
-/*
- First line of the input trace file provides metadata on the trace 
- regarding workgroup size in the form 'local size: x y z'. Where
- x, y, & z are the number of threads in the workgroup in three
- dimensions.
+    unsigned int segment = entry.getMemAddr() / segmentSize;
+    segments[b].insert(segment);
 
- If a the dimension does not exist in the thread space it's value is zero.
- This is used to record the number of dimensions in the trace.
-*/
-void setThreadDim(Trace* trace, std::ifstream& input){
-
-  char localSize[maxLineSize] ;
-  input.getline(localSize,maxLineSize);
-  unsigned int local_dim[3];
-  sscanf (localSize,"local size:%d %d %d",&local_dim[0],&local_dim[1],&local_dim[2]);
- 
-  // Count number of dimensions
-  unsigned short dim_count = 0;
-  for(unsigned int i = 0; i< maxDim; i++){
-    if(local_dim[i] > 0){
-       ++dim_count;
+    // Consecutive accesses of one warp instruction share requests
+    unsigned int key[3] = {getWorkgroupId(trace,entry),getWarpId(trace,entry),entry.getName()};
+    if(key[0] != group[0] || key[1] != group[1] || key[2] != group[2]){
+      pending.clear();
+      std::copy(key,key + 3,group);
     }
-    else {local_dim[i] = 1;}
+    if(pending.insert(segment).second)
+      ++requests[b];
   }
 
-  trace->setDim(dim_count);
-  trace->setLocalSize(local_dim[0],local_dim[1],local_dim[2]);
+  void print(unsigned int n) const{
+    std::cout << "\nBuffers of execution "<< n <<":\n";
+    for(unsigned int b = 0; b < slots; b++){
+      if(b == buffers.size() && !reads[b] && !writes[b])
+        continue;
 
-  /* 
-    Checks that the number of threads in a warp is less than the number of 
-    threads in a workgroup, since warps cannot span workgroups.
-  */
-  unsigned int workgroupSize = local_dim[0] * local_dim[1]* local_dim[2];
-  if(workgroupSize < argWarpSize){
-      trace->setWarpSize(workgroupSize);
-  }
-  else {
-      trace->setWarpSize(argWarpSize);
+      std::cout << (b < buffers.size() ? buffers[b].name : std::string("other")) << ": "
+                << reads[b] << " reads, " << writes[b] << " writes, "
+                << requests[b] << " requests, footprint "
+                << segments[b].size() * segmentSize << " bytes\n";
+    }
   }
 
-}
+ private:
+  const BUFFER_VEC& buffers;
+  unsigned int slots;
+  std::vector<unsigned long> reads,writes,requests;
+  std::vector<std::set<unsigned int> > segments;
 
-void parse(std::ifstream& input, std::vector<Trace*>& executions){
-  /*
-    Reads and parses the input file line by line, 
-    where a line is a trace entry.
-  */
-  std::string line;
+  // Segments requested by the warp instruction being coalesced
+  std::set<unsigned int> pending;
+  unsigned int group[3];
+};
 
-  Trace* curr = new Trace(); 
-  
-  // Sets the workgroup size based on first line of input file
-  setThreadDim(curr,input);
+/* 
 
-  while(getline(input,line)){
+   Schedules execution n and prints the reordered trace to files for
+   graphing and cache simulation, with the accesses of each buffer if
+   they were asked for. Replicas after the first are not graphed.
 
-    bool end =  parseInput(line,*curr);
-    if(end && !input.eof()){
+*/
+void writeOutput(Trace* trace, unsigned int n, std::ostream& cache, std::ostream* graph,
+                 const ScheduleConfig& config, unsigned int replica = 0){
 
-      if(curr->getGlobal(1) == 0) 
-        curr->setGlobalSize(1,1); 
-  
-      if(curr->getGlobal(2) == 0) 
-        curr->setGlobalSize(2,1);
 
+  /*
+    Cache simulation needs to know the number of threads in a warp and
+    total number of workgroups. This is provided as the first line
+    of the input file.
+  */
+  cache <<trace->getWarpSize() << " "<<trace->getTotalWorkgroups()<<std::endl;
 
-      // Give each access an index in the order of it's thread's accesses
-      setIndices(*curr);
+  if(useBuffers && replica == 0){
+    BufferCounts counts(argBuffers.execution(n));
+    forEachScheduled(trace,config,[&](const Trace_entry& entry){
+      writeEntry(*trace,entry,cache,graph);
+      counts.add(*trace,entry);
+    },n,replica);
+    counts.print(n);
+  }
+  else{
+    forEachScheduled(trace,config,[&](const Trace_entry& entry){
+      writeEntry(*trace,entry,cache,graph);
+    },n,replica);
+  }
 
-      executions.push_back(curr);
+  cache << "------------------------"<<std::endl;
 
+  
+}
 
-      curr = new Trace();
+/*
+  Makes the replicas' random schedules of each execution concurrently,
+  each scheduling a copy of the parsed trace with the threads shared
+  out between them. Schedule r goes to cache.out.r, and the first is
+  also graphed.
+*/
+void writeReplicas(ExecutionReader& reader){
+
+  std::vector<std::unique_ptr<std::ofstream> > outputs;
+  for(unsigned int r = 0; r < argReplicas; r++){
+    std::ostringstream name;
+    name << "cache.out." << r;
+    outputs.push_back(std::unique_ptr<std::ofstream>(new std::ofstream(name.str().c_str())));
+    if(!outputs.back()->is_open()){
+      std::cout <<"Error, could not open output file\n";
+      exit(0);
+    }
+  }
+  cache.close();
 
-      // Sets the workgroup size based on first line of input file
-      setThreadDim(curr,input);
+  ScheduleConfig config = argConfig;
+  config.threads = std::max(1u,argConfig.threads / argReplicas);
 
+  unsigned int n = 0;
+  while(Trace* curr = reader.next()){
+    std::cout << *curr <<std::endl;
 
-    }
-  } 
+    parallelFor(argReplicas,argConfig.threads,[&](unsigned int r){
+      Trace copy(*curr);
+      writeOutput(&copy,n,*outputs[r],r == 0 ? &graph : NULL,config,r);
+      outputs[r]->flush();
+    });
+    graph.flush();
 
+    delete curr;
+    n++;
+  }
+  graph.close();
 }
 
 int main(int argc, char *argv[]){
@@ -245,33 +325,49 @@ int main(int argc, char *argv[]){
   // Checks valid command line arguments are given
   validateArguments(argc,argv);
 
-  std::ifstream input_file(argv[1]);
-  if(!input_file.is_open()){
-  	std::cout << "unable to open file "<< argv[1] <<std::endl;
-  	exit(0);
-  }
-
   // Reads the scheduling algorithm to use.
   assignAlgorithm(argv,argc);
 
-  std::vector<Trace*> executions;
-
-  parse(input_file,executions);
-
+  ExecutionReader reader(argConfig);
+  if(!reader.open(argv[1])){
+  	std::cout << "unable to open file "<< argv[1] <<std::endl;
+  	exit(0);
+  }
 
   if(!graph.is_open() || !cache.is_open()  ){
     std::cout <<"Error, could not open output file\n";
     exit(0);
   }
 
+  // Random schedules can be repeated by giving their seed
+  if(Trace::algorithm == Trace::RANDOM)
+    std::cout << "Seed: "<< argConfig.seed << std::endl;
 
-  // Schedule trace according to specified algorithm.
-  if(Trace::algorithm != Trace::NONE){
-    for_each(executions.begin(),executions.end(),schedule);
+  if(argReplicas > 1){
+    if(Trace::algorithm != Trace::RANDOM){
+      std::cout << "-replicas needs the rand algorithm\n";
+      exit(0);
+    }
+    writeReplicas(reader);
+    return 0;
+  }
+
+  /*
+    Each execution is scheduled and written out as soon as it has been
+    parsed, so only one is held in memory at a time.
+  */
+  unsigned int n = 0;
+  while(Trace* curr = reader.next()){
+    std::cout << *curr <<std::endl;
+
+    // Schedules the trace and prints it to the output files.
+    writeOutput(curr,n,cache,&graph,argConfig);
+    graph.flush();
+    cache.flush();
+
+    delete curr;
+    n++;
   }
-  
-  // Prints reordered trace to output file.
-  for_each(executions.begin(),executions.end(),writeOutput);
   graph.close();
   cache.close();
 
@@ -0,0 +1,64 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped.h"
+
+bool MappedFile::open(const char* path){
+
+  int fd = ::open(path,O_RDONLY);
+  if(fd == -1)
+    return false;
+
+  struct stat info;
+  if(fstat(fd,&info) == -1 || !S_ISREG(info.st_mode)){
+    close(fd);
+    return false;
+  }
+
+  // Nothing to map in an empty file
+  length = info.st_size;
+  if(length == 0){
+    close(fd);
+    return true;
+  }
+
+  void* map = mmap(NULL,length,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if(map == MAP_FAILED){
+    length = 0;
+    return false;
+  }
+
+  // Read front to back, once
+  madvise(map,length,MADV_SEQUENTIAL);
+  data = (char*)map;
+  return true;
+}
+
+MappedFile::~MappedFile(){
+  if(data)
+    munmap(data,length);
+}
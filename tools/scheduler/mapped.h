@@ -0,0 +1,30 @@
+#ifndef MAPPED_H
+#define MAPPED_H
+
+#include <cstddef>
+
+/*
+  A whole input file mapped read-only into memory, so it can be parsed
+  in place, from several threads at once.
+*/
+class MappedFile
+{
+ public:
+  MappedFile():data(NULL),length(0){}
+  ~MappedFile();
+
+  // Maps the file, returning false if it is not a regular file that can be mapped.
+  bool open(const char* path);
+
+  const char* begin() const{ return data;}
+  const char* end() const{ return data + length;}
+
+ private:
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+  char* data;
+  size_t length;
+};
+
+#endif //MAPPED_H
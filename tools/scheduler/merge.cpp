@@ -0,0 +1,148 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+#include <algorithm>
+#include "merge.h"
+
+/*
+  Next access of one thread's stream, with the fields it is ordered on:
+  rr takes the lowest index, then the lowest thread, seq the lowest
+  thread, then its lowest index, within the earliest partition.
+*/
+struct StreamHead{
+  unsigned long long major; // Barriers the thread has passed, then the first field
+  unsigned int minor;
+  unsigned int partition;
+  unsigned int thread;      // Thread the stream belongs to
+  size_t next;              // Position of the access in the thread's stream
+};
+
+// Ordering for a min-heap, so compares the other way round
+static bool laterHead(const StreamHead& a, const StreamHead& b){
+  if(a.major != b.major)
+    return a.major > b.major;
+  return a.minor > b.minor;
+}
+
+bool mergeable(){
+  return Trace::algorithm == Trace::RR || Trace::algorithm == Trace::SEQUENTIAL;
+}
+
+/*
+  Each thread's accesses are already in program order, indexed by
+  setIndices, so rr is a k-way merge of the threads' streams by index,
+  and seq one by thread. Streams are found with a counting sort of the
+  entries' positions by thread, then merged through a heap holding the
+  head of each stream, taking O(N log T) for N accesses of T threads.
+*/
+void mergeSchedule(const Trace& trace, const std::function<void(const Trace_entry&)>& emit){
+
+  const std::vector<Trace_entry>& entries = trace.entries;
+  unsigned int threads = trace.getTotalThreads();
+  bool rr = Trace::algorithm == Trace::RR;
+
+  /*
+    Partitions follow the barriers of thread 0, as schedule() counts
+    them, so a trace where it meets none is a single partition.
+  */
+  bool partitioned = false;
+  for(size_t i = 0; i < entries.size() && !partitioned; i++){
+    partitioned = entries[i].getBarrier() && entries[i].getThreadId(0) == 0 &&
+                  entries[i].getThreadId(1) == 0 && entries[i].getThreadId(2) == 0;
+  }
+
+  // Positions of each thread's entries, in trace order
+  std::vector<size_t> start(threads + 1,0);
+  std::vector<unsigned int> owner(entries.size());
+  for(size_t i = 0; i < entries.size(); i++){
+    owner[i] = entries[i].getThreadVal(trace);
+    ++start[owner[i] + 1];
+  }
+  for(unsigned int t = 0; t < threads; t++)
+    start[t + 1] += start[t];
+
+  std::vector<size_t> stream(entries.size());
+  {
+    std::vector<size_t> fill(start.begin(),start.end() - 1);
+    for(size_t i = 0; i < entries.size(); i++)
+      stream[fill[owner[i]]++] = i;
+  }
+  std::vector<unsigned int>().swap(owner);
+
+  /*
+    Moves a head on to the next access of its thread, past any
+    barriers. Returns false at the end of the stream.
+  */
+  auto advance = [&](StreamHead& head){
+    for(; head.next < start[head.thread + 1]; head.next++){
+      const Trace_entry& e = entries[stream[head.next]];
+      if(e.getBarrier()){
+        if(partitioned)
+          ++head.partition;
+        continue;
+      }
+      head.major = ((unsigned long long)head.partition << 32) | (rr ? e.getIndex() : head.thread);
+      head.minor = rr ? head.thread : e.getIndex();
+      return true;
+    }
+    return false;
+  };
+
+  std::vector<StreamHead> heads;
+  for(unsigned int t = 0; t < threads; t++){
+    StreamHead head;
+    head.partition = 0;
+    head.thread = t;
+    head.next = start[t];
+    if(advance(head))
+      heads.push_back(head);
+  }
+  std::make_heap(heads.begin(),heads.end(),laterHead);
+
+  /*
+    The top head is emitted, moved on and sifted down in place, one
+    pass down the heap per access rather than a pop and a push.
+  */
+  while(!heads.empty()){
+    StreamHead& top = heads.front();
+    emit(entries[stream[top.next]]);
+
+    top.next++;
+    if(!advance(top)){
+      std::pop_heap(heads.begin(),heads.end(),laterHead);
+      heads.pop_back();
+      continue;
+    }
+
+    size_t hole = 0, n = heads.size();
+    StreamHead moved = top;
+    for(size_t child = 1; child < n; child = 2 * hole + 1){
+      if(child + 1 < n && laterHead(heads[child],heads[child + 1]))
+        ++child;
+      if(!laterHead(moved,heads[child]))
+        break;
+      heads[hole] = heads[child];
+      hole = child;
+    }
+    heads[hole] = moved;
+  }
+}
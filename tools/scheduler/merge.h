@@ -0,0 +1,17 @@
+#ifndef MERGE_H
+#define MERGE_H
+
+#include <functional>
+#include "trace.h"
+
+/*
+  Calls emit with each access of the trace in the order the rr or seq
+  algorithm schedules them, without sorting the trace. Barriers are
+  dropped, splitting the schedule into partitions as schedule() does.
+*/
+void mergeSchedule(const Trace& trace, const std::function<void(const Trace_entry&)>& emit);
+
+// Whether the trace's algorithm is one mergeSchedule produces.
+bool mergeable();
+
+#endif //MERGE_H
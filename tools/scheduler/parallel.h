@@ -0,0 +1,36 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/*
+  Calls task(i) for every i below count, on up to 'threads' threads,
+  each taking the next task as it finishes one. Runs on the calling
+  thread alone when one thread, or one task, is all there is.
+*/
+template <typename Task>
+void parallelFor(unsigned int count, unsigned int threads, Task task){
+
+  if(threads <= 1 || count <= 1){
+    for(unsigned int i = 0; i < count; i++)
+      task(i);
+    return;
+  }
+
+  std::atomic<unsigned int> next(0);
+  auto worker = [&](){
+    unsigned int i;
+    while((i = next++) < count)
+      task(i);
+  };
+
+  std::vector<std::thread> pool;
+  for(unsigned int t = 0; t < threads && t < count; t++)
+    pool.push_back(std::thread(worker));
+  for(unsigned int t = 0; t < pool.size(); t++)
+    pool[t].join();
+}
+
+#endif //PARALLEL_H
@@ -21,248 +21,299 @@ along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
 
 #include "trace.h"
 #include "parse.h"
+#include "parallel.h"
 
 /*
-  Takes file line in the and converts it at a Trace_entry object
-  defined in 'trace.h'
-
-  file line in the form:
-  'memory address,read/write,instruction | Thread id | loop data'
-   -------------- ---------- -----------   ----------  ---------
-    8 characters    1 char    7 char        16 chars    16 chars
+  Value of each character as a hex digit, -1 for any other character.
 */
-bool parseInput(std::string line,Trace& trace){
-
-  // Consecutive hypens indicate end of the trace.
-  if(line.find("-") < line.length()){
-   	return true;
+struct HexTable{
+  signed char digit[256];
+
+  HexTable(){
+    for(int c = 0; c < 256; c++)
+      digit[c] = -1;
+    for(int c = 0; c < 10; c++)
+      digit['0' + c] = c;
+    for(int c = 0; c < 6; c++){
+      digit['a' + c] = 10 + c;
+      digit['A' + c] = 10 + c;
+    }
   }
+};
 
-  // Creates Trace_entry object to represent to current file line
-  Trace_entry curr_entry;
-
-  // Populate loop data in the entry object.
-  getLoops(line,curr_entry);
+static const HexTable hexTable;
 
-  // Populate Thread Id in entry object.
-  getThreadIds(line,curr_entry,trace); 
-
-  if(line.find("|") <= 1){         // Checks if file line signals a memory barrier.
-	  curr_entry.setBarrier(true);
-  }else{                           // Otherwise the file line is a memory access.
-
-    // Populate memory address data in the entry object.
-    getMemoryAddress(line,curr_entry); 
-
-    // Populate instuction name in the entry object.
-    getInstruction(line,curr_entry);  
+/*
+  Decodes the hex digits from first up to last, stopping at the first
+  character which is not one, as strtoul does.
+*/
+static unsigned long long hexValue(const char* first, const char* last){
+  unsigned long long value = 0;
+  for(; first < last; ++first){
+    int d = hexTable.digit[(unsigned char)*first];
+    if(d < 0)
+      break;
+    value = (value << 4) | d;
   }
-  
-  // Give the entry a pointer to Trace object
-  curr_entry.setPointer(&trace);
-
-  // Add entry to linked list field of Trace object.
-  trace.entries.push_back(curr_entry);
-
-  return false;
+  return value;
 }
 
-
 /*
-  Populates loop data in Trace_entry object
-  from data after second '|' 
-*/
-void getLoops(std::string line,Trace_entry& curr){
-   
-  size_t pos = 0; // Position of last '|'
+  Takes a file line and converts it to a Trace_entry object
+  defined in 'trace.h', widening 'globals', the number of threads
+  in each dimension, to hold its thread.
 
-  // Get substring containing loop data
-  while((pos = line.find("|")) != std::string::npos){
-    line.erase(0,pos+1);
-  }
+  file line in the form:
+  'memory address,read/write,instruction | Thread id | loop data'
+   -------------- ---------- -----------   ----------  ---------
+    8 characters    1 char    7 char        16 chars    16 chars
 
-  // If access was not inside a loop return
-  if(strtol(line.c_str(),NULL,16) == 0){
-    curr.setLoopDepth(0);
-    return;
+  Returns false if the line is not in that form.
+*/
+bool parseRecord(const char* line, size_t length, Trace_entry& curr, unsigned int globals[maxDim]){
+
+  const char* end = line + length;
+  const char* first = (const char*)memchr(line,'|',length);
+  if(!first)
+    return false;
+  const char* second = (const char*)memchr(first + 1,'|',end - first - 1);
+  if(!second)
+    return false;
+
+  // Loop data follows the last '|'
+  const char* loops = second + 1;
+  for(const char* c = loops; c < end; ++c){
+    if(*c == '|')
+      loops = c + 1;
   }
 
-  // Copy line into char*
-  int length = line.length();   
-  char str_cpy[length];
-  strcpy(str_cpy,line.c_str());
-   
-  // Attributes that need to be populated
-  unsigned int label[maxLoops],loop_val[maxLoops];
-  unsigned int loop_num = 0;
-  
-   
-  char* substr;        // Substring for label bits
-  unsigned int hex= 0; // Conversion to hex from string
-
-  //For each possible nested loop
-  for(int i=maxLoops-1; i >= 0; --i){
-    if(i==2){
-     	// Gets loop data of the 3rd nested loop, if one exists, from the first 20 bits
-      substr = str_cpy + (length-5);
-      hex = strtol(substr,NULL,16);  //convert hex string to int
-    }
-    if(i==1){
-      // Gets loop data of second level nested loop, if exists, from bits 20 - 39
-      *substr = '\0';
-      substr = str_cpy + (length - 10);
-      hex = strtol(substr,NULL,16);  //convert hex string to int
-    }
-    if(i==0){
-      // Gets loop data, from top level loop, from bits 40 - 59
-      *substr = '\0';
-      substr = str_cpy;
-      hex = strtol(substr,NULL,16); //convert hex string to int
+  curr = Trace_entry();
+
+  /*
+    Loop data holds a 20 bit field per nested loop, the outermost in the
+    leading digits: a 4 bit label then a 16 bit iteration count.
+  */
+  if(hexValue(loops,end) != 0){
+    const char* bounds[maxLoops + 1] = {loops,
+                                        std::max(loops,end - 10),
+                                        std::max(loops,end - 5),
+                                        end};
+    unsigned int loop_num = 0;
+    for(unsigned int i = 0; i < maxLoops; i++){
+      unsigned int hex = hexValue(bounds[i],bounds[i + 1]);
+      unsigned int label = (hex >> 16) & 0xF;
+      unsigned int loop_val = hex & 0xFFFF;
+
+      // If loop value is non zero update the number of loops the instuction is in
+      if(loop_val != 0)
+        loop_num++;
+      curr.setLoopIter(i,label,loop_val);
     }
+    curr.setLoopDepth(loop_num);
+  }
 
-    // Label is first 4 bits
-    label[i] = (0xF << 16) & hex;
-    label[i]= label[i] >> 16;
-   
-    // Loop value is next 16 bits 65536 = 2^16 
-    loop_val[i] = (65535) & hex;
-   
-    // If loop value is non zero update the number of loops the instuction is in
-    if(loop_val[i] != 0)
-      loop_num++;
+  /*
+    Thread ids between the first two '|', 5 digits per dimension, the
+    first dimension in the trailing digits.
+  */
+  const char* ids = first + 1;
+  size_t idLength = second - ids;
+  unsigned int id[maxDim] = {0,0,0};
+  if(idLength <= 5){
+    id[0] = hexValue(ids,second);
+  }
+  else if(idLength <= 10){
+    id[0] = hexValue(second - 5,second);
+    id[1] = hexValue(ids,second - 5);
+  }
+  else{
+    id[0] = hexValue(second - 5,second);
+    id[1] = hexValue(second - 10,second - 5);
+    id[2] = hexValue(ids,second - 10);
+  }
+  curr.setThreadIds(id[0],id[1],id[2]);
+
+  /*
+    If an id is greater than number of threads then set the maximum
+    number of threads in the trace to the id
+  */
+  for(unsigned int d = 0; d < maxDim; d++){
+    if(id[d] >= globals[d])
+      globals[d] = id[d] + 1;
+  }
 
+  size_t fieldLength = first - line;
+  if(fieldLength <= 1){           // A single character signals a memory barrier.
+    curr.setBarrier(true);
+    return true;
   }
 
-  // Assign data to object
-  curr.setLoopDepth(loop_num);
-  curr.pushLoopIter(label[0],loop_val[0]);
-  curr.pushLoopIter(label[1],loop_val[1]);
-  curr.pushLoopIter(label[2],loop_val[2]);
- 
- 
+  /*
+    Memory address in the leading 8 of 16 digits, the field being
+    padded with zeros on the left to 16 digits.
+  */
+  if(fieldLength <= 16)
+    curr.setMemAddr(hexValue(line,first) >> 32);
+  else
+    curr.setMemAddr(hexValue(line,line + 8));
+
+  /*
+    Access type from the 9th last digit, F global read, A global write,
+    E local read, B local write, D global read of read-only data, then
+    the instruction from the last 7.
+  */
+  const char* inst = first - std::min<size_t>(fieldLength,8);
+  char type = *inst;
+  curr.setRead(type == 'F' || type == 'E' || type == 'D');
+  curr.setLocalMem(type == 'E' || type == 'B');
+  curr.setReadOnly(type == 'D');
+  curr.setName(hexValue(inst + 1,first));
+
+  return true;
 }
 
+
 /*
-  Get the memory address of the line
+  When filtering, entries are indexed here, counting the accesses
+  dropped, so the slice keeps its place in the schedule. Barriers
+  are always kept, since they partition the schedule.
 */
-void getMemoryAddress(std::string line,Trace_entry& curr){
-  
-  // Get first 8 characters as hex digits
-   line.erase(line.find("|"));
-  if(line.length() < 16){
-     line.insert(0,std::string(16-line.length(),'0'));
-  }
+bool keepEntry(Trace_entry& entry,const AccessFilter& filter,ThreadCounts& counts){
 
-  unsigned int addr = strtoul(line.substr(0,8).c_str(),NULL,16);
+  if(!filter.enabled())
+    return true;
 
-  // Converts string to base 16 int and stores address in struct
-  curr.setMemAddr(addr); 
+  unsigned long long tid = ((unsigned long long)entry.getThreadId(2) << 40) |
+                           ((unsigned long long)entry.getThreadId(1) << 20) |
+                           entry.getThreadId(0);
+  entry.setIndex(counts[tid]++);
+
+  return entry.getBarrier() || filterEntry(entry,filter);
+}
 
-} 
 
 /*
-  Get the whether the memory access was a read or write
-  from 9th bit, and decode instruction name from last 7 
-  bits before first '|'
+  Takes a file line and adds its entry to the trace, unless the filter
+  drops it. Returns true at the line ending the execution.
 */
-void getInstruction(std::string line,Trace_entry& curr){
-  line.erase(line.find("|"));
+bool parseInput(const std::string& line,Trace& trace,const AccessFilter& filter,ThreadCounts& counts){
 
+  // Consecutive hypens indicate end of the trace.
+  if(line.find("-") < line.length()){
+   	return true;
+  }
 
-  line = line.substr(line.length()-8);
+  unsigned int globals[maxDim] = {trace.getGlobal(0),trace.getGlobal(1),trace.getGlobal(2)};
+  Trace_entry curr_entry;
+  if(!parseRecord(line.data(),line.length(),curr_entry,globals))
+    return false;
 
-  // Read or write access type
-  if(line[0] == 'F')
-      curr.setRead(true);
-  else
-      curr.setRead(false);
+  for(unsigned int d = 0; d < maxDim; d++)
+    trace.setGlobalSize(d,globals[d]);
 
-  line = line.substr(1);
+  // Add entry to the entries of the Trace object.
+  if(keepEntry(curr_entry,filter,counts))
+    trace.entries.push_back(curr_entry);
 
-  // Convert string from base 16 to base 10 
-  long int as_int = strtol(line.c_str(),NULL,16); 
-                
-  // Decode from radix to get character string from integer
-  curr.setName(as_int);
+  return false;
+}
 
 
-} 
+/*
+  Lines handed to one thread at least, so small executions are parsed
+  on the calling thread.
+*/
+const size_t parseChunkMin = 1 << 20;
 
 /*
-  Populate thread id data in Trace_entry struct
+  Parses the records from first up to last, the lines of one execution
+  without its header or terminator, splitting them at line boundaries
+  into chunks parsed on up to 'threads' threads. Chunks are joined in
+  file order, then filtered in that order, so the result is the same
+  as parsing line by line.
 */
-void getThreadIds(std::string line, Trace_entry& curr,Trace& trace){
-     
-  // Get characters between two '|' 
-  line.erase(0,line.find("|")+1);
-  size_t pos = line.find("|");
-  line.erase(pos,line.length()-pos);
-
-  // Only one dimension
-  if(line.length() <= 5){
-    unsigned int hex =strtol(line.c_str(),NULL,16);      //convert string id to hex int
-    curr.setThreadIds(hex,0,0);
-
-    /*
-      if id is greater than number of threads then set the maximum
-      number of threads in the trace to the id
-    */
-    if(hex >= trace.getGlobal(0)){
-       trace.setGlobalSize(0,hex+1);
-    }    
- 
-    	
-  } 
-  else if(line.length() <= 10){ // Two dimensions
-    unsigned int length = line.length();
-    std::string id1,id2;
-    id2 = line.substr(0,length-5);
-    id1 = line.substr(length-5,5);
-     
-    unsigned int hex1 =strtol(id1.c_str(),NULL,16);
-
-    if(hex1 >= trace.getGlobal(0)){ 
-      trace.setGlobalSize(0, hex1+1);
-    }
+void parseRecords(const char* first, const char* last, Trace& trace,
+                  const AccessFilter& filter, unsigned int threads){
+
+  size_t bytes = last - first;
+  unsigned int chunks = std::max<size_t>(1,std::min<size_t>(threads,bytes / parseChunkMin));
+
+  // Chunk c starts after the first newline at or past its share of the bytes
+  std::vector<const char*> bounds(chunks + 1,last);
+  bounds[0] = first;
+  for(unsigned int c = 1; c < chunks; c++){
+    const char* split = first + bytes * c / chunks;
+    const char* newline = (const char*)memchr(split,'\n',last - split);
+    bounds[c] = newline ? std::max(newline + 1,bounds[c - 1]) : last;
+  }
 
-    //get second dimension id
-    unsigned int hex2 =strtol(id2.c_str(),NULL,16);
-    if(hex2 >= trace.getGlobal(1)){
-      trace.setGlobalSize(1,hex2+1);
-    }
+  std::vector<std::vector<Trace_entry> > parsed(chunks);
+  std::vector<std::vector<unsigned int> > globals(chunks,std::vector<unsigned int>(maxDim,0));
 
-    curr.setThreadIds(hex1,hex2,0);
+  parallelFor(chunks,threads,[&](unsigned int c){
+    std::vector<Trace_entry>& out = parsed[c];
+    const char* line = bounds[c];
+    const char* end = bounds[c + 1];
 
-   }
-   else{ //Three dimensions
-     unsigned int length = line.length();
-     std::string id1,id2,id3;
-     id3 = line.substr(0,length-10);
-     id2 = line.substr(length-10,5);
-     id1 = line.substr(length-5,5);
-      
-     unsigned int hex1 = strtol(id1.c_str(),NULL,16);
-     if(hex1 >= trace.getGlobal(0)){ 
-       trace.setGlobalSize(0, hex1+1);
-     }
+    // Rough count of the lines, records being about 30 characters
+    out.reserve((end - line) / 30 + 1);
 
+    Trace_entry entry;
+    while(line < end){
+      const char* newline = (const char*)memchr(line,'\n',end - line);
+      const char* next = newline ? newline : end;
+      if(parseRecord(line,next - line,entry,&globals[c][0]))
+        out.push_back(entry);
+      line = next + 1;
+    }
+  });
+
+  size_t total = trace.entries.size();
+  for(unsigned int c = 0; c < chunks; c++){
+    total += parsed[c].size();
+    for(unsigned int d = 0; d < maxDim; d++){
+      if(globals[c][d] > trace.getGlobal(d))
+        trace.setGlobalSize(d,globals[c][d]);
+    }
+  }
 
-     //get second dimension id
-     unsigned int hex2 =strtol(id2.c_str(),NULL,16);
-     if(hex2 >= trace.getGlobal(1)){
-       trace.setGlobalSize(1,hex2+1);
+  trace.entries.reserve(total);
+  ThreadCounts counts;
+  for(unsigned int c = 0; c < chunks; c++){
+    if(!filter.enabled()){
+      trace.entries.insert(trace.entries.end(),parsed[c].begin(),parsed[c].end());
+    }
+    else{
+      for(size_t i = 0; i < parsed[c].size(); i++){
+        if(keepEntry(parsed[c][i],filter,counts))
+          trace.entries.push_back(parsed[c][i]);
+      }
+    }
+    std::vector<Trace_entry>().swap(parsed[c]);
+  }
+}
 
-     }
 
-     //get third dimension id
-     unsigned int hex3 =strtol(id3.c_str(),NULL,16);
-     if(hex3 >= trace.getGlobal(2)){
-       trace.setGlobalSize(2,hex3+1);
-     }
+/*
+  Checks the fields of an access known while parsing against the filter.
+  Workgroups depend on the size of the whole thread space, so are
+  checked once the execution has been read.
+*/
+bool filterEntry(const Trace_entry& entry,const AccessFilter& filter){
 
-     curr.setThreadIds(hex1,hex2,hex3);
+  if(!filter.matches(FILTER_INST,entry.getName()) ||
+     !filter.matches(FILTER_ADDR,entry.getMemAddr()) ||
+     !filter.matches(FILTER_OP,entry.getRead()))
+    return false;
 
-   }
-  
-} 
+  if(!filter.uses(FILTER_LOOP))
+    return true;
 
+  unsigned int labels[maxLoops],iterations[maxLoops];
+  const Loop_timestamp& loops = entry.getLoops();
+  for(unsigned int i=0;i<maxLoops;i++){
+    labels[i] = loops.labels[i];
+    iterations[i] = loops.iterations[i];
+  }
+  return filter.matches_loops(labels,iterations,maxLoops);
+}
@@ -1,21 +1,28 @@
-#ifndef PARSE_H
-#define PARSE_H
+#ifndef SCHEDULER_PARSE_H
+#define SCHEDULER_PARSE_H
 
-// Converts a file line into a Trace_entry object.
-bool parseInput(std::string line,Trace& trace);
+#include <unordered_map>
+#include "filter.h"
 
-// Populate loop data in the Trace)entry object.
-void getLoops(std::string line,Trace_entry& curr);
+// Accesses made so far by each thread, keyed on its packed thread ids.
+typedef std::unordered_map<unsigned long long,unsigned int> ThreadCounts;
 
-// Populate memory address data in the entry object.
-void getMemoryAddress(std::string line,Trace_entry& curr); 
+// Converts a file line into a Trace_entry object, unless the filter drops it.
+// While filtering, each thread's accesses are counted in 'counts' to index them.
+bool parseInput(const std::string& line,Trace& trace,const AccessFilter& filter,ThreadCounts& counts);
 
-// Populate instuction name in the entry object.
-void getInstruction(std::string line,Trace_entry& curr);  
+// Decodes a file line of 'length' characters into 'curr', widening the number
+// of threads in each dimension, 'globals', to hold its thread. False if not a record.
+bool parseRecord(const char* line,size_t length,Trace_entry& curr,unsigned int globals[maxDim]);
 
-// Populate Thread Id in entry object.
-void getThreadIds(std::string line, Trace_entry& curr,Trace& t); 
+// Parses the lines of an execution between its header and terminator,
+// in chunks on up to 'threads' threads, into the trace.
+void parseRecords(const char* first,const char* last,Trace& trace,const AccessFilter& filter,unsigned int threads);
 
-unsigned int decodeRadix(int input);
+// Indexes an entry while filtering, and returns whether the filter keeps it.
+bool keepEntry(Trace_entry& entry,const AccessFilter& filter,ThreadCounts& counts);
 
-#endif //PARSE_H
\ No newline at end of file
+// Whether an access passes the filter, leaving aside its workgroup
+bool filterEntry(const Trace_entry& entry,const AccessFilter& filter);
+
+#endif //SCHEDULER_PARSE_H
\ No newline at end of file
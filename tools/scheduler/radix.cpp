@@ -0,0 +1,154 @@
+/*
+
+Copyright 2014 Ewan Crawford<ewan.cr@gmail.com>
+
+
+This file is part of OpenCL Visuliser.
+
+OpenCL Visuliser is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCL Visuliser is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+#include "radix.h"
+#include "parallel.h"
+
+const unsigned int radixBits = 8;                       // Bits sorted per pass
+const unsigned int radixBuckets = 1 << radixBits;
+const unsigned int radixPasses = 128 / radixBits;       // Passes over both key words
+
+/*
+  A key travels with the position of its entry, so passes read
+  and write memory sequentially.
+*/
+struct KeyIndex{
+  SortKey key;
+  unsigned int index;
+};
+
+static unsigned int digit(const SortKey& key, unsigned int pass){
+  unsigned int shift = (pass % (radixPasses / 2)) * radixBits;
+  unsigned long long word = pass < radixPasses / 2 ? key.lo : key.hi;
+  return (word >> shift) & (radixBuckets - 1);
+}
+
+/*
+  Sorts n keys on one digit per pass, least significant first, using
+  'to' as scratch space. The counts of every digit are taken in a single
+  pass beforehand, and passes where every key has the same digit are
+  skipped, so narrow keys cost only the passes their bits need.
+  The sorted keys end up back in 'from'.
+*/
+static void sortKeys(KeyIndex* from, KeyIndex* to, size_t n){
+
+  if(n < 2)
+    return;
+
+  std::vector<size_t> counts(radixPasses * radixBuckets,0);
+  for(size_t i = 0; i < n; i++){
+    for(unsigned int p = 0; p < radixPasses; p++)
+      ++counts[p * radixBuckets + digit(from[i].key,p)];
+  }
+
+  KeyIndex* src = from;
+  KeyIndex* dst = to;
+  for(unsigned int p = 0; p < radixPasses; p++){
+    size_t* count = &counts[p * radixBuckets];
+
+    // All keys share this digit
+    if(count[digit(src[0].key,p)] == n)
+      continue;
+
+    // Position of the first key with each digit
+    size_t total = 0;
+    for(unsigned int b = 0; b < radixBuckets; b++){
+      size_t c = count[b];
+      count[b] = total;
+      total += c;
+    }
+
+    for(size_t i = 0; i < n; i++)
+      dst[count[digit(src[i].key,p)]++] = src[i];
+    std::swap(src,dst);
+  }
+
+  if(src != from)
+    std::copy(src,src + n,from);
+}
+
+static bool keyLess(const KeyIndex& a, const KeyIndex& b){
+  if(a.key.hi != b.key.hi)
+    return a.key.hi < b.key.hi;
+  return a.key.lo < b.key.lo;
+}
+
+/*
+  Below this many entries a sort is not split between threads.
+*/
+const size_t parallelMin = 1 << 16;
+
+void radixSort(std::vector<Trace_entry>& entries, const std::vector<SortKey>& keys, unsigned int threads){
+
+  size_t n = entries.size();
+  if(n < 2)
+    return;
+
+  std::vector<KeyIndex> from(n),to(n);
+  for(size_t i = 0; i < n; i++){
+    from[i].key = keys[i];
+    from[i].index = i;
+  }
+
+  // Chunks sorted concurrently, each a contiguous run of the input
+  unsigned int chunks = n < parallelMin ? 1 : std::max(1u,threads);
+  std::vector<size_t> bounds(chunks + 1);
+  for(unsigned int c = 0; c <= chunks; c++)
+    bounds[c] = n * c / chunks;
+
+  parallelFor(chunks,threads,[&](unsigned int c){
+    sortKeys(&from[bounds[c]],&to[bounds[c]],bounds[c + 1] - bounds[c]);
+  });
+
+  /*
+    Neighbouring runs are merged pairwise until one is left. std::merge
+    takes equal keys from the earlier run first, so the result is the
+    order a single stable sort gives.
+  */
+  for(unsigned int width = 1; width < chunks; width *= 2){
+    unsigned int pairs = (chunks + 2 * width - 1) / (2 * width);
+    parallelFor(pairs,threads,[&](unsigned int p){
+      unsigned int first = p * 2 * width;
+      size_t lo = bounds[first];
+      size_t mid = bounds[std::min(first + width,chunks)];
+      size_t hi = bounds[std::min(first + 2 * width,chunks)];
+      std::merge(from.begin() + lo,from.begin() + mid,from.begin() + mid,from.begin() + hi,
+                 to.begin() + lo,keyLess);
+    });
+    from.swap(to);
+  }
+  std::vector<KeyIndex>().swap(to);
+
+  std::vector<Trace_entry> sorted(n);
+  parallelFor(chunks,threads,[&](unsigned int c){
+    for(size_t i = bounds[c]; i < bounds[c + 1]; i++)
+      sorted[i] = entries[from[i].index];
+  });
+  entries.swap(sorted);
+}
+
+unsigned int bitsFor(unsigned long long max){
+  unsigned int bits = 0;
+  while(bits < 64 && (max >> bits) != 0)
+    ++bits;
+  return bits;
+}
@@ -0,0 +1,25 @@
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <vector>
+#include "trace.h"
+
+/*
+  Sort key of an entry, compared on hi then lo.
+*/
+struct SortKey{
+  unsigned long long hi;
+  unsigned long long lo;
+};
+
+/*
+  Stable LSD radix sort of entries by their keys, keys[i] belonging to
+  entries[i]. With several threads, large inputs are split into chunks
+  sorted concurrently, then merged stably, giving the same order.
+*/
+void radixSort(std::vector<Trace_entry>& entries, const std::vector<SortKey>& keys, unsigned int threads = 1);
+
+// Number of bits needed to hold values up to max.
+unsigned int bitsFor(unsigned long long max);
+
+#endif //RADIX_H
@@ -21,110 +21,100 @@ along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
 
 #include "trace.h"
 #include "schedule.h"
+#include "issue.h"
+#include "parallel.h"
+#include "radix.h"
+#include "warp.h"
 #include <array>
 #include <queue>
 
 /*
-  Prioritse entries based on index, 
-  and if entries are from same index then on thread ID.
-
-  This gives a round robin ordering.
+  Counter based generator, splitmix64's output function. The value
+  drawn for a counter depends on it alone, so draws share no state and
+  can be made in any order on any thread, and a seed fixes a schedule.
 */
-bool rr_compare( const Trace_entry& a, const Trace_entry& b){
-  if(a.getIndex() != b.getIndex())
-    return a.getIndex() < b.getIndex();
-  
-  if(a.getThreadId(2)!= b.getThreadId(2)) 
-    return a.getThreadId(2) < b.getThreadId(2);
-  
-  if(a.getThreadId(1) != b.getThreadId(1)) 
-    return a.getThreadId(1) < b.getThreadId(1);
-   
-  return a.getThreadId(0) < b.getThreadId(0);
-  
-}
-
-/*
-  Prioritse entries based on thread ID, 
-  and if entries are from same thread then on index.
-
-  This gives a sequential ordering.
-*/
-bool seq_compare( const Trace_entry& a, const Trace_entry& b){
-  if(a.getThreadId(2) != b.getThreadId(2)) 
-    return a.getThreadId(2) < b.getThreadId(2);
-  
-  if(a.getThreadId(1)!= b.getThreadId(1)) 
-    return a.getThreadId(1)< b.getThreadId(1);
-   
-  if(a.getThreadId(0) != b.getThreadId(0)) 
-    return a.getThreadId(0) < b.getThreadId(0);
-  
-
-  return a.getIndex() < b.getIndex();
-  
+static inline unsigned long long splitmix(unsigned long long x){
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
 }
 
-bool random_compare( const Trace_entry& a, const Trace_entry& b){
-  
-  return a.getPriority() < b.getPriority();
-  
+unsigned long long scheduleSeed(unsigned long long seed, unsigned int replica, unsigned int execution){
+  // The seed is mixed before the replica is added, so neighbouring
+  // seeds do not share replicas' streams
+  return splitmix(splitmix(splitmix(seed) + replica) + execution);
 }
 
 /*
-  Assins random priotities to each of the entries so they can be
-  sorted randomly.
+  Sort keys giving a random schedule. Each thread draws a random
+  priority, and each entry is ranked on its thread's priority plus its
+  index, so earlier accesses of a thread are ranked higher than later
+  ones, preserving intra-thread ordering. Entries of different threads
+  given the same rank are ordered by a random draw of their own, in
+  place of shuffling the entries before a stable sort.
 */
-void assignPriorities(std::list<Trace_entry>& list){
- 
-  const Trace *trace = list.begin()->getPointer();
-  std::vector<unsigned int> prioirties;
-  std::srand(time(0));
-  unsigned int NumThreads = trace->getTotalThreads();
-
-  // Give each thread a priority 
-  for(unsigned int i=0; i< NumThreads; ++i){
-    prioirties.push_back(rand() % ((NumThreads / 4 )+1));
-  }
+void randomKeys(const Trace& trace, std::vector<Trace_entry>& entries, std::vector<SortKey>& keys,
+                unsigned long long seed){
 
-  /* 
-    Give each entry a priority so that earlier accesses
-     are ranked higher than later ones, to preseve
-     intra-thread ordering.
-  */
-  for( std::list<Trace_entry>::iterator iter = list.begin(), \
-        end = list.end();iter!=end;++iter){
-       unsigned int p = prioirties.at(iter->getThreadVal(*trace));
+  unsigned int range = trace.getTotalThreads() / 4 + 1;
 
-      iter->setPriority(p + iter->getIndex());
+  keys.resize(entries.size());
+  for(size_t i = 0; i < entries.size(); i++){
+    unsigned long long thread = splitmix(seed + entries[i].getThreadVal(trace));
+    unsigned int p = thread % range;
+
+    entries[i].setPriority(p + entries[i].getIndex());
+    keys[i].hi = entries[i].getPriority();
+    keys[i].lo = splitmix(thread + entries[i].getIndex()) >> 32;
   }
+}
 
-  // Scramble linked list
-  std::vector<Trace_entry> tmpVec = std::vector<Trace_entry>(list.begin(),list.end());
-  std::random_shuffle(tmpVec.begin(),tmpVec.end());
-  list = std::list<Trace_entry>(tmpVec.begin(),tmpVec.end());
 
+/*
+  Sorts entries into coalesced order: loop iterations, instruction,
+  warp, then thread. Keys are compared one by one if they do not fit.
+*/
+void coalescedSort(const Trace& trace, std::vector<Trace_entry>& entries, std::vector<SortKey>& keys,
+                   unsigned int threads){
+  // defined in warp.cpp
+  if(warpKeys(trace,entries,keys))
+    radixSort(entries,keys,threads);
+  else
+    std::stable_sort(entries.begin(),entries.end(),
+                     [&trace](const Trace_entry& a, const Trace_entry& b){
+                       return warp_compare(trace,a,b);
+                     });
 }
 
 
 /*
-   Calls routine to sort linked list depending on algorithm
+   Calls routine to sort entries depending on algorithm. Sorts are
+   stable, as the linked list sort they replace was. Each entry's
+   sort key is computed once and the entries radix sorted on them,
+   on up to 'threads' threads. 'seed' fixes a random schedule. The
+   warp scheduling policies issue the warp instructions of the
+   coalesced order. The rr and seq schedules are merged by
+   mergeSchedule instead, so are left unsorted.
 */
-void sort(std::list<Trace_entry>& list){
+void sort(const Trace& trace, std::vector<Trace_entry>& entries, unsigned int threads,
+          unsigned long long seed, const IssueModel& issue){
 
+    std::vector<SortKey> keys;
     switch(Trace::algorithm){
-     case Trace::RR :
-        list.sort(rr_compare); 
-        break;
-     case Trace::SEQUENTIAL :
-        list.sort(seq_compare);
-        break;
      case Trace::COALESCED :
-          list.sort(warp_compare); // defined in warp.cpp
+        coalescedSort(trace,entries,keys,threads);
+        break;
+     case Trace::GTO :
+     case Trace::LRR :
+     case Trace::TWO_LEVEL :
+        coalescedSort(trace,entries,keys,threads);
+        std::vector<SortKey>().swap(keys);
+        issueOrder(trace,entries,issue);
         break;
      case Trace::RANDOM :
-        assignPriorities(list); // give each entry a random priority
-        list.sort(random_compare);
+        randomKeys(trace,entries,keys,seed); // give each entry a random priority
+        radixSort(entries,keys,threads);
         break;
      default: 
         break;
@@ -133,11 +123,11 @@ void sort(std::list<Trace_entry>& list){
 
 
 /*
-  Reorders the Trace_entry elements in the Trace linked links
-  according the the scheduling algorithm.
+  Reorders the Trace_entry elements in the Trace
+  according the the scheduling algorithm, on up to 'threads' threads.
 
 */
-void schedule(Trace* trace){
+void schedule(Trace* trace, unsigned int threads, unsigned long long seed, const IssueModel& issue){
  
  /*
    Count the number of memory barriers in the trace.
@@ -148,7 +138,7 @@ void schedule(Trace* trace){
 
 
  unsigned int barrier_count = 1;
- for( std::list<Trace_entry>::const_iterator iter = trace->entries.begin(), \
+ for( std::vector<Trace_entry>::const_iterator iter = trace->entries.begin(), \
         end = trace->entries.end();iter!=end;++iter)
   {  
 
@@ -164,17 +154,17 @@ void schedule(Trace* trace){
   
  
  if(barrier_count == 1){            // No barriers
-    sort(trace->entries);
+    sort(*trace,trace->entries,threads,seed,issue);
  } else {                           //Barriers are present
 
-   // Pariton list into a linked list for entries between barriers
-   std::list<Trace_entry>* split = new std::list<Trace_entry>[barrier_count];
+   // Pariton entries into a vector for entries between barriers
+   std::vector<std::vector<Trace_entry> > split(barrier_count);
    
    // Record the number of barriers seen by each thread.
    std::vector<int>barriers_seen(trace->getTotalThreads(),0);
 
    //Assign each entry to a partition.
-   for( std::list<Trace_entry>::const_iterator iter = trace->entries.begin(), \
+   for( std::vector<Trace_entry>::const_iterator iter = trace->entries.begin(), \
         end = trace->entries.end();iter!=end;++iter)
     {
         unsigned int tVal = iter->getThreadVal(*trace);
@@ -187,20 +177,29 @@ void schedule(Trace* trace){
 
         split[index].push_back(*iter);
      }
-
-    // Sort each of the patitions
-    for(unsigned int i=0;i<barrier_count;i++){
-        split[i].sort(rr_compare);
-        sort(split[i]);
-    }
+    std::vector<Trace_entry>().swap(trace->entries);
+
+    /*
+      Sort each of the patitions concurrently, threads left over once
+      every partition has one being shared within them. A thread's
+      entries stay in index order within a partition, so the stable
+      sort keeps each thread's accesses in program order. Each
+      partition draws its random priorities from a seed of its own.
+    */
+    unsigned int inner = std::max(1u,threads / barrier_count);
+    parallelFor(barrier_count,threads,[&](unsigned int i){
+        sort(*trace,split[i],inner,splitmix(seed + i),issue);
+    });
     
     //combine partitions togeth
-    trace->entries.clear();
+    size_t total = 0;
+    for(unsigned int i=0;i<barrier_count;i++)
+      total += split[i].size();
+    trace->entries.reserve(total);
     for(unsigned int i=0;i<barrier_count;i++){
-      trace->entries.splice(trace->entries.end(),split[i]);
+      trace->entries.insert(trace->entries.end(),split[i].begin(),split[i].end());
+      std::vector<Trace_entry>().swap(split[i]);
     }
-
-   delete[] split;
  }
 
 
@@ -1,8 +1,16 @@
 #ifndef SIG_H
 #define SIG_H
 
-void schedule(Trace* trace);
+#include "issue.h"
 
-bool warp_compare( const Trace_entry& a, const Trace_entry& b);
+// Reorders the trace, 'seed' fixing the priorities of a random schedule
+// and 'issue' modelling the warp scheduling policies.
+void schedule(Trace* trace, unsigned int threads = 1, unsigned long long seed = 0,
+              const IssueModel& issue = IssueModel());
+
+// Seed of the random schedule of an execution in one of several replicas.
+unsigned long long scheduleSeed(unsigned long long seed, unsigned int replica, unsigned int execution);
+
+bool warp_compare( const Trace& t, const Trace_entry& a, const Trace_entry& b);
 
 #endif
\ No newline at end of file
@@ -24,17 +24,6 @@ along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
 
 Trace::Algorithm Trace::algorithm = Trace::NONE;
 
-void Trace_entry::pushLoopIter(unsigned int label, unsigned int counter){
-  loops.counters.push_back(std::tuple<unsigned int,unsigned int>(label,counter));
-}
-
- 
-void Trace_entry::setThreadIds(unsigned int d1, unsigned int d2, unsigned int d3){
-  t_id.push_back(d1);
-  t_id.push_back(d2);
-  t_id.push_back(d3);
-}
-
 /*
   Calculates a unique ID for a thread based
   on it's id in all dimensions and the total 
@@ -55,21 +44,23 @@ unsigned int Trace_entry::getThreadVal(const Trace& t)const{
 
 
 std::ostream & operator<< (std::ostream & os, const Trace_entry& right){
-  os << "T ID: " <<right.t_id.at(0)<< " "<< right.t_id.at(1) << " " <<right.t_id.at(2)<<std::endl;
+  os << "T ID: " <<right.t_id[0]<< " "<< right.t_id[1] << " " <<right.t_id[2]<<std::endl;
   os <<"Index: " <<right.index<<std::endl;
-  os << "Loop depth " << right.loops.depth<<std::endl;
+  os << "Loop depth " << (unsigned int)right.loops.depth<<std::endl;
 
   for(int i=0;i<right.loops.depth;i++){
-    os << "label "<<std::get<0>(right.loops.counters[i])<<" Val " \
-    << std::get<1>(right.loops.counters[i])<<std::endl; 
+    os << "label "<<(unsigned int)right.loops.labels[i]<<" Val " \
+    << right.loops.iterations[i]<<std::endl; 
   }
 
-  if(!right.barrier){
-    os << "Read: " << right.read <<std::endl;
+  if(!right.getBarrier()){
+    os << "Read: " << right.getRead() <<std::endl;
+    os << "Local: " << right.getLocalMem() <<std::endl;
+    os << "Read only: " << right.getReadOnly() <<std::endl;
     os << "ADDR: " <<std::hex << right.mem_addr <<std::dec <<std::endl;
     os << "Instr: "<<right.inst<<std::endl;
   }else{
-    os <<"Barrier: " <<right.barrier<<std::endl;
+    os <<"Barrier: " <<right.getBarrier()<<std::endl;
   }
 
   os <<std::endl;
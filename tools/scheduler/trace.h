@@ -6,7 +6,6 @@
 #include <cstdlib>
 #include <string>
 #include <iostream>
-#include <list>
 #include <algorithm>
 #include <vector>
 #include <tuple>
@@ -22,28 +21,43 @@ typedef std::tuple<int,unsigned int> loopTuple;
 
 class Trace;
 
-//Strcture representing any loops that the memory access was in
+/*
+  Strcture representing any loops that the memory access was in.
+  Labels are 4 bits and iteration counts 16 bits in the trace, so
+  the counters are packed inline rather than held in a vector.
+*/
 struct Loop_timestamp{
 
-  int depth;                        //Number of nested loops 
+  unsigned char depth;                    //Number of nested loops 
 
-  std::vector<loopTuple> counters;  //Loop execution counter 
+  unsigned char labels[maxLoops];         //Loop label of each counter
+  unsigned short iterations[maxLoops];    //Loop execution counter, 0 if not in the loop
 };
 
 
+/*
+  A memory access or barrier of one thread. Entries are plain data held
+  contiguously by their Trace, so anything needing the size of the
+  thread space is given the Trace alongside the entry.
+*/
 class Trace_entry
 {
 
  private:
-  unsigned int index;     // Index in thread execution
-  Loop_timestamp loops;   // Loop Data
-  std::vector<unsigned int> t_id; // Thread ID
+  unsigned int index;             // Index in thread execution
+  unsigned int t_id[maxDim];      // Thread ID
   unsigned int mem_addr;          // Memory Address
-  bool barrier;                   // Is a barrier
-  bool read;                      // Memory read or write
   unsigned int inst;              // Instrucion which made access
   unsigned int priority;          // priority for random scheduling
-  const Trace *trace_ptr;         // pointer to Trace class
+  Loop_timestamp loops;           // Loop Data
+  unsigned char flags;            // ENTRY_ bits below
+
+  static const unsigned char ENTRY_BARRIER   = 1;   // Is a barrier
+  static const unsigned char ENTRY_READ      = 2;   // Memory read or write
+  static const unsigned char ENTRY_LOCAL     = 4;   // Access to __local rather than __global memory
+  static const unsigned char ENTRY_READ_ONLY = 8;   // Load of data the kernel never writes
+
+  void setFlag(unsigned char flag, bool val){ flags = val ? (flags | flag) : (flags & ~flag);}
 
  public:
 
@@ -55,35 +69,49 @@ class Trace_entry
     void setPriority(unsigned int p){priority= p;}
     unsigned int getPriority()const{return priority;}
 
-    void setPointer(const Trace* ptr) { trace_ptr = ptr;}
-    const Trace* getPointer() const { return trace_ptr;}
-
-    void setBarrier(bool val){barrier = val;}
-    bool getBarrier()const {return barrier;}
+    void setBarrier(bool val){setFlag(ENTRY_BARRIER,val);}
+    bool getBarrier()const {return flags & ENTRY_BARRIER;}
   
-    void setRead(bool val){read = val;}
-    bool getRead() const{return read;}
+    void setRead(bool val){setFlag(ENTRY_READ,val);}
+    bool getRead() const{return flags & ENTRY_READ;}
+
+    void setLocalMem(bool val){setFlag(ENTRY_LOCAL,val);}
+    bool getLocalMem() const{return flags & ENTRY_LOCAL;}
+
+    void setReadOnly(bool val){setFlag(ENTRY_READ_ONLY,val);}
+    bool getReadOnly() const{return flags & ENTRY_READ_ONLY;}
   
     void setIndex(unsigned int val){index = val;}
     unsigned int getIndex()const{return index;}
   
     void setLoopDepth(unsigned int i){loops.depth = i;}
-    void pushLoopIter(unsigned int label, unsigned int counter);
+    void setLoopIter(unsigned int level, unsigned int label, unsigned int counter){
+      loops.labels[level] = label;
+      loops.iterations[level] = counter;
+    }
  
     unsigned int getLoopDepth() const { return loops.depth;}
-    Loop_timestamp getLoops() const { return loops;}
+    const Loop_timestamp& getLoops() const { return loops;}
 
-    void setThreadIds(unsigned int, unsigned int, unsigned int);
+    void setThreadIds(unsigned int d1, unsigned int d2, unsigned int d3){
+      t_id[0] = d1;
+      t_id[1] = d2;
+      t_id[2] = d3;
+    }
     unsigned int getThreadId(unsigned int index) const{
-      return t_id.at(index);
+      return t_id[index];
     }
     unsigned int getThreadVal(const Trace& t)const;
      
     unsigned int getMemAddr() const{return mem_addr;}
     void setMemAddr(unsigned int addr){mem_addr = addr;}
 
-	  Trace_entry() :barrier(false),priority(0) {};
-   ~Trace_entry() {};
+    Trace_entry() :index(0),mem_addr(0),inst(0),priority(0),flags(0) {
+      t_id[0] = t_id[1] = t_id[2] = 0;
+      loops.depth = 0;
+      for(unsigned int i=0;i<maxLoops;i++)
+        setLoopIter(i,0,0);
+    };
 };
 
 
@@ -91,13 +119,16 @@ class Trace_entry
 class Trace{
  
   public:
-   std::list<Trace_entry> entries;
+   std::vector<Trace_entry> entries;
 
    enum Algorithm{ //Possible scheduling algorithms
      RR,
      SEQUENTIAL,
      COALESCED,
      RANDOM,
+     GTO,          // Warp scheduling policies, see issue.h
+     LRR,
+     TWO_LEVEL,
      NONE
    };
    static Trace::Algorithm algorithm; //Scheduling algoritm
@@ -21,14 +21,15 @@ along with OpenCL Visuliser.  If not, see <http://www.gnu.org/licenses/>
 
 #include "trace.h"
 #include "warp.h"
+#include "radix.h"
 #include <limits>
 
 
 std::ostream & operator<< (std::ostream & os, const Loop_timestamp& right){
-  os<<"Loop depth "<<right.depth <<std::endl;
-  for ( auto loop : right.counters ){
-             os << "label: " << std::get<0>(loop)\
-                <<" val "<< std::get<1>(loop) <<std::endl;
+  os<<"Loop depth "<<(unsigned int)right.depth <<std::endl;
+  for (unsigned int i = 0; i < maxLoops; i++){
+             os << "label: " << (unsigned int)right.labels[i]\
+                <<" val "<< right.iterations[i] <<std::endl;
          
     }
 
@@ -38,16 +39,16 @@ std::ostream & operator<< (std::ostream & os, const Loop_timestamp& right){
 /*
  calculates the lowest loop label creater than a paramtized minimum
 */
-loopTuple minGreaterThan(std::vector<loopTuple> vec,int minLabel){
+loopTuple minGreaterThan(const Loop_timestamp& loops,int minLabel){
   
     unsigned int minVal =0;
 
     int lowestL= std::numeric_limits<int>::max();
 
-    for ( auto loop : vec ){
-         if(std::get<0>(loop) < lowestL && std::get<0>(loop) > minLabel){
-             lowestL = std::get<0>(loop); 
-             minVal = std::get<1>(loop);
+    for (unsigned int i = 0; i < maxLoops; i++){
+         if(loops.labels[i] < lowestL && loops.labels[i] > minLabel){
+             lowestL = loops.labels[i]; 
+             minVal = loops.iterations[i];
          }
     }
 
@@ -72,8 +73,8 @@ bool earlierLoop(const Loop_timestamp& a, const Loop_timestamp& b){
     
      
       //find not processes outermost loop
-      minA = minGreaterThan(a.counters,std::get<0>(minA));
-      minB = minGreaterThan(b.counters,std::get<0>(minB));
+      minA = minGreaterThan(a,std::get<0>(minA));
+      minB = minGreaterThan(b,std::get<0>(minB));
   
      
       //if outmost loops if not to same 
@@ -95,21 +96,21 @@ bool earlierLoop(const Loop_timestamp& a, const Loop_timestamp& b){
   Calculates and workgroup of an access
   based on it thread id and workgroup size 
 */
-unsigned int getWorkgroupId(const Trace_entry& a){
+unsigned int getWorkgroupId(const Trace& t, const Trace_entry& a){
 
- unsigned int D1Workgroups = a.getPointer()->workgroupsByDim(0);
- unsigned int D2Workgroups = a.getPointer()->workgroupsByDim(1);
+ unsigned int D1Workgroups = t.workgroupsByDim(0);
+ unsigned int D2Workgroups = t.workgroupsByDim(1);
 
- unsigned int D1 = a.getThreadId(0) / a.getPointer()->getLocal(0);
+ unsigned int D1 = a.getThreadId(0) / t.getLocal(0);
  unsigned int D2 = 0;
  unsigned int D3 = 0;
 
-if(a.getPointer()->getDim() > 1){
-    D2 = a.getThreadId(1) / a.getPointer()->getLocal(1);
+if(t.getDim() > 1){
+    D2 = a.getThreadId(1) / t.getLocal(1);
   }
   
-if(a.getPointer()->getDim() > 2){
-    D3 = a.getThreadId(2) / a.getPointer()->getLocal(2);
+if(t.getDim() > 2){
+    D3 = a.getThreadId(2) / t.getLocal(2);
 } 
 
 unsigned int result = D1 + (D2 * D1Workgroups);
@@ -125,32 +126,32 @@ return result;
    Caluclates the the warp id of an entry basen on the 
    workgroup of the thread and number of warps per workgroup
 */
-unsigned int getWarpId(const Trace_entry& a){
+unsigned int getWarpId(const Trace& t, const Trace_entry& a){
   
-  unsigned int workgroup = getWorkgroupId(a);
+  unsigned int workgroup = getWorkgroupId(t,a);
 
   //Number of warps in each dimension of a workgroup
-  unsigned int warp1D = a.getThreadId(0) % a.getPointer()->getLocal(0);
+  unsigned int warp1D = a.getThreadId(0) % t.getLocal(0);
   unsigned int warp2D = 0;
   unsigned int warp3D = 0;
 
-  if(a.getPointer()->getDim() > 1){
-    warp2D = a.getThreadId(1) % a.getPointer()->getLocal(1);
+  if(t.getDim() > 1){
+    warp2D = a.getThreadId(1) % t.getLocal(1);
   }
 
 
-  if(a.getPointer()->getDim() > 2){
-    warp3D = a.getThreadId(2) % a.getPointer()->getLocal(2);
+  if(t.getDim() > 2){
+    warp3D = a.getThreadId(2) % t.getLocal(2);
   }
   
-  unsigned int result = warp1D + (warp2D * a.getPointer()->getLocal(0));
+  unsigned int result = warp1D + (warp2D * t.getLocal(0));
 
-  result += warp3D * (a.getPointer()->getLocal(0) * a.getPointer()->getLocal(1));
+  result += warp3D * (t.getLocal(0) * t.getLocal(1));
  
-  result /= a.getPointer()->getWarpSize();
+  result /= t.getWarpSize();
 
- // result = result + (workgroup *  a.getPointer()->warpsPerWorkgroup());  
-  result = workgroup + (result * a.getPointer()->getTotalWorkgroups());  
+ // result = result + (workgroup *  t.warpsPerWorkgroup());  
+  result = workgroup + (result * t.getTotalWorkgroups());  
 
   return result;
 }
@@ -172,7 +173,7 @@ unsigned int getWarpId(const Trace_entry& a){
 
 */
 
-bool warp_compare( const Trace_entry& a, const Trace_entry& b){
+bool warp_compare( const Trace& t, const Trace_entry& a, const Trace_entry& b){
 
   // entry A is executed in a loop before entry B
   if (earlierLoop(a.getLoops(),b.getLoops()) ){
@@ -193,15 +194,120 @@ bool warp_compare( const Trace_entry& a, const Trace_entry& b){
   }
   // entry A is executed in a 'earlier' warp than entry B
 
-  unsigned int warpA = getWarpId(a);
-  unsigned int warpB = getWarpId(b);
+  unsigned int warpA = getWarpId(t,a);
+  unsigned int warpB = getWarpId(t,b);
 
   if(warpA != warpB){
      return warpA < warpB;
   }
 
   // entry A is has a lower thread id than enry B
-  return a.getThreadVal(*(a.getPointer())) < b.getThreadVal(*(b.getPointer()));
+  return a.getThreadVal(t) < b.getThreadVal(t);
 
 
-}
\ No newline at end of file
+}
+
+/*
+  Loop levels of a sort key, each a 5 bit label code and a 16 bit
+  iteration count.
+*/
+const unsigned int keyLevelBits = 21;
+const unsigned int keyIterBits = 16;
+const unsigned int labelNone = 17;     // Code of a level earlierLoop finds no label for
+const unsigned int labelAfter = 31;    // Code placing an access after every loop of a level
+
+/*
+  Label codes and iterations of the loops of an entry, outermost first,
+  in the order earlierLoop compares them.
+*/
+static unsigned int loopLevels(const Loop_timestamp& loops, unsigned int codes[], unsigned int iters[]){
+  loopTuple level = loopTuple(-1,0);
+  for(unsigned int i = 0; i < loops.depth; i++){
+    level = minGreaterThan(loops,std::get<0>(level));
+    codes[i] = std::get<0>(level) == std::numeric_limits<int>::max() ? labelNone : std::get<0>(level) + 1;
+    iters[i] = std::get<1>(level);
+  }
+  return loops.depth;
+}
+
+/*
+  Computes the coalesced sort key of each entry: the loop iterations
+  it was made in, then its instruction, warp and thread, so sorting
+  on the keys orders the entries as warp_compare does.
+
+  earlierLoop only compares the loops both entries are in, so an access
+  outside a loop ties with every iteration of it, and falls back to the
+  instruction. That is not a strict weak order. Keys make it one by
+  placing such an access before the first loop of the level whose
+  instructions all come after its own, or after every loop of the
+  level if there is none, which is where the instruction order puts
+  it in a well formed trace.
+
+  Returns false if the instruction, warp and thread fields do not fit
+  in 64 bits.
+*/
+bool warpKeys(const Trace& t, const std::vector<Trace_entry>& entries, std::vector<SortKey>& keys){
+
+  // Lowest instruction inside each loop of each level
+  const unsigned int codes = labelAfter + 1;
+  std::vector<unsigned int> firstInst(maxLoops * codes,std::numeric_limits<unsigned int>::max());
+
+  unsigned int maxInst = 0, maxWarp = 0, maxThread = 0;
+  std::vector<unsigned int> warps(entries.size());
+
+  for(size_t i = 0; i < entries.size(); i++){
+    const Trace_entry& e = entries[i];
+    unsigned int code[maxLoops],iter[maxLoops];
+    unsigned int depth = loopLevels(e.getLoops(),code,iter);
+
+    for(unsigned int l = 0; l < depth; l++){
+      unsigned int& first = firstInst[l * codes + code[l]];
+      first = std::min(first,e.getName());
+    }
+
+    warps[i] = getWarpId(t,e);
+    maxInst = std::max(maxInst,e.getName());
+    maxWarp = std::max(maxWarp,warps[i]);
+    maxThread = std::max(maxThread,e.getThreadVal(t));
+  }
+
+  unsigned int threadBits = bitsFor(maxThread);
+  unsigned int warpBits = bitsFor(maxWarp);
+  if(bitsFor(maxInst) + warpBits + threadBits > 64)
+    return false;
+
+  keys.resize(entries.size());
+  for(size_t i = 0; i < entries.size(); i++){
+    const Trace_entry& e = entries[i];
+    unsigned int code[maxLoops],iter[maxLoops];
+    unsigned int depth = loopLevels(e.getLoops(),code,iter);
+
+    // Outside a loop at the next level, placed by instruction
+    if(depth < maxLoops){
+      unsigned int after = labelAfter;
+      for(unsigned int c = 0; c < labelAfter; c++){
+        if(firstInst[depth * codes + c] != std::numeric_limits<unsigned int>::max() &&
+           firstInst[depth * codes + c] > e.getName()){
+          after = c;
+          break;
+        }
+      }
+      code[depth] = after;
+      iter[depth] = 0;
+      depth++;
+    }
+
+    unsigned long long hi = 0;
+    for(unsigned int l = 0; l < maxLoops; l++){
+      hi <<= keyLevelBits;
+      if(l < depth)
+        hi |= ((unsigned long long)code[l] << keyIterBits) | iter[l];
+    }
+
+    keys[i].hi = hi;
+    keys[i].lo = ((unsigned long long)e.getName() << (warpBits + threadBits)) |
+                 ((unsigned long long)warps[i] << threadBits) | e.getThreadVal(t);
+  }
+
+  return true;
+}
@@ -1,8 +1,13 @@
 #ifndef WARP_H
 #define WARP_H
 
-unsigned int getWarpId(const Trace_entry& a);
+#include "radix.h"
 
-unsigned int getWorkgroupId(const Trace_entry& a);
+unsigned int getWarpId(const Trace& t, const Trace_entry& a);
+
+unsigned int getWorkgroupId(const Trace& t, const Trace_entry& a);
+
+// Sort keys ordering entries for coalesced scheduling, false if they do not fit.
+bool warpKeys(const Trace& t, const std::vector<Trace_entry>& entries, std::vector<SortKey>& keys);
 
 #endif //WARP_H
\ No newline at end of file
@@ -66,7 +66,7 @@ def parseArgs():
     parser.add_option("-a","--algorithm",
                          action="store",
                          type="choice",
-                         choices=["coalesced","rr","seq","rand","none"],
+                         choices=["coalesced","rr","seq","rand","gto","lrr","twolevel","none"],
                          default="none",
                          dest="alg",
                          help="Scheduling algorithm")
@@ -108,8 +108,14 @@ def main():
 
     trace = os.getcwd() + "/trace.txt"
     scheduler_path = build_dir+"/scheduler/scheduler "
+
+    # Device address ranges of the kernel's buffers, written by the wrapper
+    buffers = os.getcwd() + "/buffers.txt"
+    buffer_arg = ""
+    if os.path.isfile(buffers):
+      buffer_arg = " -buffers " + buffers
    
-    os.system(scheduler_path + trace + " " +opts.alg + " "+str(opts.warp));
+    os.system(scheduler_path + trace + " " +opts.alg + " "+str(opts.warp) + buffer_arg);
     os.system("rm " + trace);
     
     graph = os.getcwd()+ "/graph.out"
@@ -120,10 +126,12 @@ def main():
 
     os.system("Rscript " + R_path + graph)
     if opts.sim:
-      os.system(cache_path + cache + " 16 128 4 LRU WTNA")
+      os.system(cache_path + cache + " 16 128 4 LRU WTNA" + buffer_arg)
    
     os.system("rm " + graph)
     os.system("rm " + cache)
+    if buffer_arg:
+      os.system("rm " + buffers)
     os.system("mv " + graph+".png " + os.getcwd()+"/"+program+".png") 
 
 if __name__ == "__main__":